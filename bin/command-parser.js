@@ -15,7 +15,8 @@ String.prototype.indent = function (level) {
   return this.split('\n').map(line => (' '.repeat(level * 2) + line).trimEnd()).join('\n')
 }
 
-const stdtype = str => str === 'string' ? 'std::string' : str
+// strings are views into the command line, see parse().
+const stdtype = str => str === 'string' ? 'std::string_view' : str
 const nodestd = str => {
   const map = {
     int: 'number',
@@ -31,13 +32,14 @@ const type = (arg, std = stdtype(arg.type)) => arg.array
     ? `Optional<${std}>`
     : std
 const nodeType = (arg, std = nodestd(arg.type)) => arg.array ? `${std}[]` : std
+// varname is a string_view, not necessarily zero-terminated.
 const getValue = (type, varname) => {
-  if (type === 'int') return `atoi(${varname})`
+  if (type === 'int') return `atoi(${varname}.data())`
   if (type === 'bool') return `${varname}[0] == 't'`
-  if (type === 'char') return `*${varname}`
+  if (type === 'char') return `${varname}[0]`
   if (type === 'SortType') return `${varname}[0] == 't' ? kTime : kCost`
-  if (type === 'Duration') return `Duration(atoi(${varname}))`
-  if ([ 'Date', 'Instant' ].includes(type)) return `${type}(${varname})`
+  if (type === 'Duration') return `Duration(atoi(${varname}.data()))`
+  if ([ 'Date', 'Instant' ].includes(type)) return `${type}(${varname}.data())`
   return varname
 }
 const getNodeValue = (type, varname) => {
@@ -50,7 +52,21 @@ const getNodeValue = (type, varname) => {
   return `CPP_STR(${varname})`
 }
 
-const ARG_RE = /^(?<type>[^ ]+) (?<name>[a-zA-Z0-9]+)(?<optional>\?)?(?<array>\[\])?(?<default> = .+)?$/
+// reads a value of the binary protocol, see protocol.h.
+const readValue = type => {
+  if (type === 'int') return 'in.i32()'
+  if (type === 'bool') return 'in.u8() != 0'
+  if (type === 'char') return '(char) in.u8()'
+  if (type === 'SortType') return 'in.u8() == 0 ? kTime : kCost'
+  if (type === 'Duration') return 'Duration(in.i32())'
+  if (type === 'Date') return 'in.date()'
+  if (type === 'Instant') return 'in.instant()'
+  return 'in.string()'
+}
+
+// "string<max> name[count]": max and count are the most
+// bytes and elements the data files hold, see decoder.
+const ARG_RE = /^(?<type>[^ <]+)(<(?<max>[0-9]+)>)? (?<name>[a-zA-Z0-9]+)(?<optional>\?)?(?<array>\[(?<count>[0-9]*)\])?(?<default> = .+)?$/
 const parseArg = str => str.match(ARG_RE).groups
 const declareArg = ([ _, value ]) => {
   const parsed = parseArg(value)
@@ -61,41 +77,98 @@ const declareNodeArg = ([ _, value ]) => {
   return `${parsed.name}${parsed.optional || parsed.default ? '?' : ''}: ${nodeType(parsed)}`
 }
 const getArray = (name, parsed, varname) => {
-  if (parsed.type === 'string') return `std::string val = ${varname};
-  res.${name} = copyStrings(split(val, '|'));`
-  return `std::string val = ${varname};
-  auto values = split(val, '|');
+  if (parsed.type === 'string') return `res.${name} = splitView(${varname}, '|');`
+  return `auto values = splitView(${varname}, '|');
   res.${name}.reserve(values.size());
   for (auto &str : values) {
-    res.${name}.push_back(${getValue(parsed.type, 'str.data()')});
+    res.${name}.push_back(${getValue(parsed.type, 'str')});
   }`
 }
 const getNodeArray = (name, parsed, varname) => `
 {
   auto array = ${varname}.As<Napi::Array>();
-  cmd.${name}.reserve(array.Length());
+  cmd.${name}.reserve(array.Length());${parsed.type === 'string' ? `
+  // reserved, so that the strings never move.
+  ${name}Strs.reserve(array.Length());
+  for (int i = 0; i < array.Length(); ++i) {
+    ${name}Strs.push_back(CPP_STR(array.Get(i)));
+    cmd.${name}.push_back(${name}Strs.back());
+  }` : `
   for (int i = 0; i < array.Length(); ++i) {
     cmd.${name}.push_back(${getNodeValue(parsed.type, 'array.Get(i)')});
-  }
+  }`}
 }
 `.trim()
+// every flag is a dash and a letter, so parse() switches on
+// the letter.
+const FLAG_RE = /^-[a-zA-Z]$/
 const testArg = ([ name, value ]) => {
+  if (!FLAG_RE.test(name)) throw new Error(`bad flag ${name}`)
   const parsed = parseArg(value)
-  return `
-if (arg == "${name}") {
-  ${parsed.array
-    ? getArray(parsed.name, parsed, 'argv[++i].data()')
-    : `res.${parsed.name} = ${getValue(parsed.type, 'argv[++i].data()')};`}
-} else
+  return parsed.array
+    ? `
+case '${name[1]}': {
+  ${getArray(parsed.name, parsed, 'argv[++i]')}
+  break;
+}
+`.slice(1, -1)
+    : `
+case '${name[1]}':
+  res.${parsed.name} = ${getValue(parsed.type, 'argv[++i]')};
+  break;
 `.slice(1, -1)
 }
+// the command only holds views of strings, so the strings
+// themselves are kept next to it, named after the arguments.
+const nodeStorage = ([ _, value ]) => {
+  const parsed = parseArg(value)
+  if (parsed.type !== 'string') return []
+  return [ parsed.array
+    ? `Vector<std::string> ${parsed.name}Strs;`
+    : `std::string ${parsed.name}Str;` ]
+}
 const nodeArg = ([ _, value ]) => {
   const parsed = parseArg(value)
   if (parsed.array) return getNodeArray(parsed.name, parsed, `args.Get("${parsed.name}")`)
+  const getter = getNodeValue(parsed.type, `args.Get("${parsed.name}")`)
   return `
-${parsed.optional || parsed.default ? `if (!isNullish(args.Get("${parsed.name}"))) ` : ''}cmd.${parsed.name} = ${getNodeValue(parsed.type, `args.Get("${parsed.name}")`)};
+${parsed.optional || parsed.default ? `if (!isNullish(args.Get("${parsed.name}"))) ` : ''}cmd.${parsed.name} = ${parsed.type === 'string' ? `${parsed.name}Str = ${getter}` : getter};
 `.trim()
 }
+// the arguments are read in the order of commands.yml.
+// the strings and arrays too long for the data files are
+// rejected, as run() would throw on them.
+const readArg = ([ _, value ]) => {
+  const parsed = parseArg(value)
+  const checkMax = varname => parsed.max
+    ? `\nif (${varname}.length() > ${parsed.max}) return ParseException();`
+    : ''
+  if (parsed.array) {
+    return `
+{
+  auto n = in.u16();${parsed.count ? `
+  if (n > ${parsed.count}) return ParseException();` : ''}
+  res.${parsed.name}.reserve(n);
+  for (unsigned i = 0; i < n && in.ok(); ++i) {
+${parsed.max ? `
+    auto value = ${readValue(parsed.type)};${checkMax('value').indent(2)}
+    res.${parsed.name}.push_back(value);`.slice(1) : `
+    res.${parsed.name}.push_back(${readValue(parsed.type)});`.slice(1)}
+  }
+}
+`.slice(1, -1)
+  }
+  if (parsed.optional || parsed.default) {
+    if (!parsed.max) return `if (in.u8() != 0) res.${parsed.name} = ${readValue(parsed.type)};`
+    return `
+if (in.u8() != 0) {
+  auto value = ${readValue(parsed.type)};${checkMax('value').indent(1)}
+  res.${parsed.name} = value;
+}
+`.slice(1, -1)
+  }
+  return `res.${parsed.name} = ${readValue(parsed.type)};${checkMax(`res.${parsed.name}`)}`
+}
 const header = ([ name, args ]) => `
 struct ${className(name)} {
   ${Object.entries(args).map(declareArg).join('\n  ')}
@@ -108,33 +181,112 @@ ${Object.entries(args).map(declareNodeArg).join('\n').indent(1)}
 `.slice(1)
 
 const implementation = ([ name, args ]) => `
-if (argv0 == "${name}") {
+auto parse${className(name)} (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
 ${Object.keys(args).length == 0 ? `
   return Command(${className(name)}());`.slice(1) : `
   ${className(name)} res;
   for (int i = 1; i < argv.size(); ++i) {
     auto &arg = argv[i];
-${Object.entries(args).map(testArg).join(' ').indent(2)} {
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
       return ParseException();
     }
+    switch (arg[1]) {
+${Object.entries(args).map(testArg).join('\n').indent(3)}
+      default:
+        return ParseException();
+    }
   }
   return res;
 `.slice(1, -1)}
-} else
+}
+`.trim()
+
+const decoder = ([ name, args ]) => `
+auto decode${className(name)} (binary::Reader &in)
+  -> Result<Command, ParseException> {
+${Object.keys(args).length == 0 ? `
+  if (!in.done()) return ParseException();
+  return Command(${className(name)}());`.slice(1) : `
+  ${className(name)} res;
+${Object.entries(args).map(readArg).join('\n').indent(1)}
+  if (!in.done()) return ParseException();
+  return res;`.slice(1)}
+}
 `.trim()
+
+// dispatches on the length of the command name, and then on
+// the first character telling apart the names of that
+// length. the name is still compared in full, so that
+// unknown commands are rejected.
+const dispatch = names => {
+  const call = name => `if (argv0 == "${name}") return parse${className(name)}(argv);`
+  const byLength = new Map()
+  for (const name of names) {
+    if (!byLength.has(name.length)) byLength.set(name.length, [])
+    byLength.get(name.length).push(name)
+  }
+  const group = names => {
+    if (names.length === 1) return call(names[0])
+    const ix = [ ...names[0] ].findIndex((_, i) =>
+      new Set(names.map(name => name[i])).size === names.length)
+    if (ix === -1) return names.map(call).join('\n')
+    return `
+switch (argv0[${ix}]) {
+${names.map(name => `
+  case '${name[ix]}':
+    ${call(name)}
+    break;
+`.slice(1, -1)).join('\n')}
+}
+`.slice(1, -1)
+  }
+  return `
+switch (argv0.length()) {
+${[ ...byLength.keys() ].sort((a, b) => a - b).map(length => `
+  case ${length}:
+${group(byLength.get(length)).indent(2)}
+    break;
+`.slice(1, -1)).join('\n')}
+}
+return ParseException();
+`.slice(1, -1)
+}
+// the arguments of a command, with the strings the command
+// views, read on the main thread and run on the thread pool.
 const nodeImplementation = ([ name, args ]) => `
+struct Node${className(name)} {
+  static constexpr bool readOnly = ${isReadOnly(name)};
+${[ `${className(name)} cmd;` ].concat(Object.entries(args).flatMap(nodeStorage)).join('\n').indent(1)}
+
+${Object.keys(args).length == 0 ? `
+  auto read (const Napi::CallbackInfo & /* unused */) -> void {}`.slice(1) : `
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+${Object.entries(args).map(nodeArg).join('\n').indent(2)}
+  }`.slice(1)}
+};
+
 auto node${className(name)} (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  ${className(name)} cmd;
-  ${Object.keys(args).length == 0 ? '' : `
-  auto args = info[0].ToObject();
-${Object.entries(args).map(nodeArg).join('\n').indent(1)}
-  `.trimStart()}return handleCommand(info.Env(), cmd);
+  return submit<Node${className(name)}>(info);
+}
+`.trim()
+
+// exit does not run on the thread pool, see node::ExitJob.
+const nodeExitImplementation = `
+auto nodeExit (const Napi::CallbackInfo &info)
+  -> Napi::Value {
+  return node::JobQueue::submit(new node::ExitJob(info.Env()));
 }
 `.trim()
 
+// the queries never change the data, so they may run
+// concurrently, see scheduler.h.
+const isReadOnly = name => name.startsWith('query_')
+
 const runOverload = name => `auto run (const ${name} &cmd) -> Result<Response, Exception>;`
-const nodeDeclaration = ([ name, value ]) => `export function ${className(name).slice(0, 1).toLowerCase()}${className(name).slice(1)} (${Object.keys(value).length === 0 ? '' : `options: ${className(name)}Options`}): Response`
+const nodeDeclaration = ([ name, value ]) => `export function ${className(name).slice(0, 1).toLowerCase()}${className(name).slice(1)} (${Object.keys(value).length === 0 ? '' : `options: ${className(name)}Options`}): Promise<Response>`
 
 const createExport = name => `exports["${name.slice(0, 1).toLowerCase()}${name.slice(1)}"] = Napi::Function::New(env, node${name});`
 
@@ -180,6 +332,7 @@ ${autogenDisclaimer}
 #define ${defineGuard}
 
 #include <iostream>
+#include <string_view>
 
 #include "datetime.h"
 #include "exception.h"
@@ -201,12 +354,35 @@ using Command = Variant<
 /**
  * @brief parses the command stored in str.
  *
+ * the strings in the command are views into str, so str
+ * must outlive the command.
+ *
  * this function is autogenerated.
  */
 auto parse (std::string &str)
   -> Result<Command, ParseException>;
 auto parse (const Vector<std::string_view> &argv)
   -> Result<Command, ParseException>;
+/**
+ * @brief decodes a command in the binary protocol, i.e. its
+ * tag and its arguments, see protocol.h.
+ *
+ * the strings in the command are views into body.
+ *
+ * this function is autogenerated.
+ */
+auto decode (std::string_view body)
+  -> Result<Command, ParseException>;
+
+/**
+ * @brief checks if the command only reads the data, i.e. if
+ * it is a query.
+ *
+ * this function is autogenerated.
+ */
+inline auto isReadOnly (const Command &cmd) -> bool {
+  return ${Object.keys(commands).filter(isReadOnly).map(name => `cmd.is<${className(name)}>()`).join('\n    || ')};
+}
 
 } // namespace ${ns}
 
@@ -218,10 +394,19 @@ ${autogenDisclaimer}
 
 #include "${filenameH}"
 
+#include "binary.h"
 #include "utility.h"
 
 namespace ${ns} {
 
+namespace {
+
+${Object.entries(commands).map(implementation).join('\n\n')}
+
+${Object.entries(commands).map(decoder).join('\n\n')}
+
+} // namespace
+
 auto parse (std::string &str)
   -> Result<Command, ParseException> {
   auto argv = split(str, ' ');
@@ -231,8 +416,20 @@ auto parse (std::string &str)
 auto parse (const Vector<std::string_view> &argv)
   -> Result<Command, ParseException> {
   auto &argv0 = argv[0];
-${Object.entries(commands).map(implementation).join(' ').indent(1)} {
-    return ParseException();
+${dispatch(Object.keys(commands)).indent(1)}
+}
+
+auto decode (std::string_view body)
+  -> Result<Command, ParseException> {
+  binary::Reader in(body);
+  // the tag is the index of the command in commands.yml.
+  switch (in.u8()) {
+${Object.keys(commands).map((name, i) => `
+  case ${i}:
+    return decode${className(name)}(in);
+`.slice(1, -1)).join('\n').indent(1)}
+    default:
+      return ParseException();
   }
 }
 
@@ -247,10 +444,8 @@ ${autogenDisclaimer}
 
 #include <napi.h>
 
-#include "exception.h"
+#include "node-queue.h"
 #include "parser.h"
-#include "response.h"
-#include "result.h"
 #include "vector.h"
 
 namespace ${ns} {
@@ -259,34 +454,23 @@ inline auto isNullish (Napi::Value value) -> bool {
   return value.IsNull() || value.IsUndefined();
 }
 
-template <typename Cmd>
-inline auto handleCommand (Napi::Env env, const Cmd &cmd)
-  -> Napi::Value {
-  try {
-    auto resp = run(cmd);
-    if (auto err = resp.error()) {
-      auto error = Napi::Error::New(env, err->what());
-      error.ThrowAsJavaScriptException();
-      return {};
-    }
-    Napi::Value res;
-    resp.result().visit([&env, &res] (const auto &resp) {
-      res = response::toJsObject(env, resp);
-    });
-
-    return res;
-  } catch (const Exception &e) {
-    auto error = Napi::Error::New(env, e.what());
-    error.ThrowAsJavaScriptException();
-    return {};
-  }
+/**
+ * @brief reads the arguments, and queues the command.
+ *
+ * @return a Promise of the response.
+ */
+template <typename Args>
+inline auto submit (const Napi::CallbackInfo &info) -> Napi::Value {
+  auto *job = new node::CommandJob<Args>(info.Env());
+  job->args.read(info);
+  return node::JobQueue::submit(job);
 }
 
 #define CPP_STR(x) ((x).As<Napi::String>().Utf8Value())
 #define CPP_INT(x) ((x).As<Napi::Number>().Int32Value())
 #define CPP_BOOL(x) ((x).As<Napi::Boolean>().Value())
 
-${Object.entries(commands).map(nodeImplementation).join('\n\n')}
+${Object.entries(commands).map(entry => entry[0] == 'exit' ? nodeExitImplementation : nodeImplementation(entry)).join('\n\n')}
 
 #undef CPP_STR
 #undef CPP_INT
@@ -295,6 +479,7 @@ ${Object.entries(commands).map(nodeImplementation).join('\n\n')}
 auto init (Napi::Env env, Napi::Object exports)
  -> Napi::Object {
 ${Object.keys(commands).map(className).map(createExport).join('\n').indent(1)}
+  exports["execBatch"] = Napi::Function::New(env, node::execBatch);
   return exports;
 }
 
@@ -318,6 +503,12 @@ export type Instant = \`\${NumberSegment}:\${NumberSegment}\`
 
 ${Object.entries(commands).map(nodeInterface).join('')}
 ${Object.entries(commands).map(nodeDeclaration).join('\n')}
+/**
+ * Runs the requests back to back, and resolves with their
+ * responses. Both are frames of the binary protocol, see
+ * src/protocol.h.
+ */
+export function execBatch (requests: Uint8Array): Promise<Uint8Array>
 `.slice(1)
 
 const dir = 'src/'
@@ -64,6 +64,8 @@ interface QueryTicketOptions {
   to: string
   date: DateString
   sort?: SortType
+  limit?: number
+  offset?: number
 }
 interface QueryTransferOptions {
   from: string
@@ -71,6 +73,13 @@ interface QueryTransferOptions {
   date: DateString
   sort?: SortType
 }
+interface QueryJourneyOptions {
+  from: string
+  to: string
+  date: DateString
+  sort?: SortType
+  transfers?: number
+}
 interface BuyTicketOptions {
   currentUser: string
   train: string
@@ -80,8 +89,18 @@ interface BuyTicketOptions {
   to: string
   queue?: boolean
 }
+interface BuyTicketsOptions {
+  currentUser: string
+  trains: string[]
+  dates: DateString[]
+  seats: number[]
+  from: string[]
+  to: string[]
+}
 interface QueryOrderOptions {
   currentUser: string
+  limit?: number
+  offset?: number
 }
 interface RefundTicketOptions {
   currentUser: string
@@ -91,20 +110,28 @@ interface RollbackOptions {
   timestamp: number
 }
 
-export function addUser (options: AddUserOptions): Response
-export function login (options: LoginOptions): Response
-export function logout (options: LogoutOptions): Response
-export function queryProfile (options: QueryProfileOptions): Response
-export function modifyProfile (options: ModifyProfileOptions): Response
-export function addTrain (options: AddTrainOptions): Response
-export function deleteTrain (options: DeleteTrainOptions): Response
-export function releaseTrain (options: ReleaseTrainOptions): Response
-export function queryTrain (options: QueryTrainOptions): Response
-export function queryTicket (options: QueryTicketOptions): Response
-export function queryTransfer (options: QueryTransferOptions): Response
-export function buyTicket (options: BuyTicketOptions): Response
-export function queryOrder (options: QueryOrderOptions): Response
-export function refundTicket (options: RefundTicketOptions): Response
-export function rollback (options: RollbackOptions): Response
-export function clean (): Response
-export function exit (): Response
+export function addUser (options: AddUserOptions): Promise<Response>
+export function login (options: LoginOptions): Promise<Response>
+export function logout (options: LogoutOptions): Promise<Response>
+export function queryProfile (options: QueryProfileOptions): Promise<Response>
+export function modifyProfile (options: ModifyProfileOptions): Promise<Response>
+export function addTrain (options: AddTrainOptions): Promise<Response>
+export function deleteTrain (options: DeleteTrainOptions): Promise<Response>
+export function releaseTrain (options: ReleaseTrainOptions): Promise<Response>
+export function queryTrain (options: QueryTrainOptions): Promise<Response>
+export function queryTicket (options: QueryTicketOptions): Promise<Response>
+export function queryTransfer (options: QueryTransferOptions): Promise<Response>
+export function queryJourney (options: QueryJourneyOptions): Promise<Response>
+export function buyTicket (options: BuyTicketOptions): Promise<Response>
+export function buyTickets (options: BuyTicketsOptions): Promise<Response>
+export function queryOrder (options: QueryOrderOptions): Promise<Response>
+export function refundTicket (options: RefundTicketOptions): Promise<Response>
+export function rollback (options: RollbackOptions): Promise<Response>
+export function clean (): Promise<Response>
+export function exit (): Promise<Response>
+/**
+ * Runs the requests back to back, and resolves with their
+ * responses. Both are frames of the binary protocol, see
+ * src/protocol.h.
+ */
+export function execBatch (requests: Uint8Array): Promise<Uint8Array>
@@ -58,6 +58,44 @@ auto sort (Iterator first, Iterator last, Compare cmp = {})
   TICKET_ASSERT(i == distance);
 }
 
+/**
+ * @brief sorts the smallest (middle - first) elements
+ * between first and last into [first, middle).
+ *
+ * the order of the elements in [middle, last) is
+ * unspecified. it takes O(n log k) time, where k is the
+ * number of elements selected.
+ */
+template <typename Iterator, class Compare = Less<>>
+auto partialSort (Iterator first, Iterator middle,
+                  Iterator last, Compare cmp = {}) -> void {
+  int k = middle - first;
+  if (k <= 0) return;
+  // a max-heap of the k smallest elements seen so far.
+  auto at = [&] (int i) -> decltype(*first) {
+    return *(first + i);
+  };
+  auto siftDown = [&] (int i) {
+    while (true) {
+      int max = i;
+      int l = 2 * i + 1, r = l + 1;
+      if (l < k && cmp.lt(at(max), at(l))) max = l;
+      if (r < k && cmp.lt(at(max), at(r))) max = r;
+      if (max == i) return;
+      std::swap(at(i), at(max));
+      i = max;
+    }
+  };
+  for (int i = k / 2 - 1; i >= 0; --i) siftDown(i);
+  for (auto it = middle; it != last; ++it) {
+    if (cmp.lt(*it, *first)) {
+      std::swap(*it, *first);
+      siftDown(0);
+    }
+  }
+  sort(first, middle, cmp);
+}
+
 } // namespace ticket
 
 #endif // TICKET_LIB_ALGORITHM_H_
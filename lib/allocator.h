@@ -0,0 +1,141 @@
+// This file defines the allocators of the containers.
+#ifndef TICKET_LIB_ALLOCATOR_H_
+#define TICKET_LIB_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace ticket {
+
+/**
+ * @brief The default allocator of Vector, HashMap and
+ * PriorityQueue.
+ *
+ * An allocator is a type with two static functions,
+ * allocate(bytes, alignment) and deallocate(ptr, bytes), so
+ * that it takes no room in the containers.
+ */
+struct HeapAllocator {
+  static auto allocate (size_t n, size_t) -> void * {
+    return ::operator new(n);
+  }
+  static auto deallocate (void *ptr, size_t) -> void {
+    ::operator delete(ptr);
+  }
+};
+
+/**
+ * @brief A monotonic buffer for the temporaries of a
+ * command.
+ *
+ * Allocating bumps a pointer in the current block, and
+ * freeing does nothing; everything is freed at once by
+ * reset(), which keeps the largest block for the next
+ * command, so a command of the usual size allocates nothing
+ * from the heap after the first few.
+ *
+ * There is one arena per thread (see local()), as commands
+ * may run concurrently. It is reset when the outermost
+ * Scope on the thread ends, and containers using
+ * ArenaAllocator must not outlive that Scope.
+ */
+class Arena {
+ public:
+  class Scope;
+
+  Arena () = default;
+  Arena (const Arena &) = delete;
+  auto operator= (const Arena &) -> Arena & = delete;
+  ~Arena () {
+    release_(blocks_);
+  }
+
+  /// gets n bytes aligned to align, a power of 2.
+  auto allocate (size_t n, size_t align) -> void * {
+    auto ptr = (cursor_ + align - 1) & ~(align - 1);
+    if (ptr + n > end_) return refill_(n, align);
+    cursor_ = ptr + n;
+    return (void *) ptr;
+  }
+  /// frees all the allocations.
+  auto reset () -> void {
+    if (blocks_ == nullptr) return;
+    release_(blocks_->next);
+    blocks_->next = nullptr;
+    if (blocks_->size > kMaxKept) {
+      release_(blocks_);
+      blocks_ = nullptr;
+      cursor_ = end_ = 0;
+      return;
+    }
+    cursor_ = (uintptr_t) (blocks_ + 1);
+  }
+
+  /// gets the arena of this thread.
+  static auto local () -> Arena & {
+    static thread_local Arena arena;
+    return arena;
+  }
+
+ private:
+  /// the header of a block, followed by its bytes.
+  struct alignas(std::max_align_t) Block {
+    Block *next;
+    size_t size;
+  };
+  static constexpr size_t kMinBlock = 1 << 16;
+  /// the largest block kept across commands.
+  static constexpr size_t kMaxKept = 1 << 24;
+
+  /// the blocks, the current and largest one first.
+  Block *blocks_ = nullptr;
+  uintptr_t cursor_ = 0, end_ = 0;
+  int depth_ = 0;
+
+  auto refill_ (size_t n, size_t align) -> void * {
+    size_t size = blocks_ == nullptr ? kMinBlock : blocks_->size * 2;
+    while (size < n + align) size *= 2;
+    auto block = (Block *) malloc(sizeof(Block) + size);
+    if (block == nullptr) throw std::bad_alloc();
+    *block = { blocks_, size };
+    blocks_ = block;
+    cursor_ = (uintptr_t) (block + 1);
+    end_ = cursor_ + size;
+    return allocate(n, align);
+  }
+  static auto release_ (Block *block) -> void {
+    while (block != nullptr) {
+      auto next = block->next;
+      free(block);
+      block = next;
+    }
+  }
+};
+
+/// The lifetime of the temporaries of a command.
+class Arena::Scope {
+ public:
+  Scope () : arena_(local()) { ++arena_.depth_; }
+  Scope (const Scope &) = delete;
+  auto operator= (const Scope &) -> Scope & = delete;
+  ~Scope () {
+    if (--arena_.depth_ == 0) arena_.reset();
+  }
+
+ private:
+  Arena &arena_;
+};
+
+/// Allocates from the arena of this thread, in a Scope.
+struct ArenaAllocator {
+  static auto allocate (size_t n, size_t align) -> void * {
+    return Arena::local().allocate(n, align);
+  }
+  static auto deallocate (void *, size_t) -> void {}
+};
+
+} // namespace ticket
+
+#endif // TICKET_LIB_ALLOCATOR_H_
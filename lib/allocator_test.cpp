@@ -0,0 +1,73 @@
+#include "allocator.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "hashmap.h"
+#include "priority-queue.h"
+#include "vector.h"
+
+using ticket::Arena;
+
+struct alignas(32) Wide {
+  char bytes[40];
+};
+
+auto fill () -> void * {
+  ticket::ArenaVector<ticket::ArenaVector<std::string>> lists;
+  ticket::ArenaHashMap<int, int> index;
+  ticket::ArenaPriorityQueue<int> queue;
+  for (int i = 0; i < 10000; ++i) {
+    auto &ix = index[i % 97];
+    if (ix == 0) {
+      lists.push_back({});
+      ix = lists.size();
+    }
+    lists[ix - 1].push_back(std::to_string(i));
+    queue.push(i % 1013);
+  }
+  assert(lists.size() == 97);
+  assert(lists[0].size() == 104 && lists[0][103] == "9991");
+  for (int i = 1012; i >= 0; --i) {
+    assert(queue.top() == i);
+    while (!queue.empty() && queue.top() == i) queue.pop();
+  }
+  assert(queue.empty());
+  return Arena::local().allocate(1, 1);
+}
+
+auto main () -> int {
+  {
+    Arena::Scope scope;
+    auto first = fill();
+    {
+      // an inner scope does not reset the arena.
+      Arena::Scope inner;
+      assert(Arena::local().allocate(1, 1) != first);
+    }
+    auto wide = Arena::local().allocate(sizeof(Wide), alignof(Wide));
+    assert((uintptr_t) wide % alignof(Wide) == 0);
+  }
+  // the blocks are reused after the reset.
+  void *first;
+  {
+    Arena::Scope scope;
+    first = Arena::local().allocate(1, 1);
+  }
+  {
+    Arena::Scope scope;
+    assert(Arena::local().allocate(1, 1) == first);
+    fill();
+  }
+  // every thread has an arena of its own.
+  std::thread other([first] {
+    Arena::Scope scope;
+    assert(Arena::local().allocate(1, 1) != first);
+    fill();
+  });
+  other.join();
+  return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef TICKET_LIB_BINARY_H_
+#define TICKET_LIB_BINARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "datetime.h"
+
+namespace ticket::binary {
+
+/**
+ * @brief Reads little-endian values from a buffer.
+ *
+ * The integers are in little-endian, the strings are
+ * prefixed with their lengths as 2-byte integers, dates are
+ * a byte of the month and a byte of the day, and instants
+ * are a byte of the hour and a byte of the minute.
+ *
+ * Reading past the end gives zeros and empty strings, and
+ * makes ok() false, so that a whole message may be read
+ * before checking it.
+ */
+class Reader {
+ public:
+  explicit Reader (std::string_view buf) : buf_(buf) {}
+
+  auto u8 () -> unsigned { return (unsigned) uint_(1); }
+  auto u16 () -> unsigned { return (unsigned) uint_(2); }
+  auto u32 () -> uint32_t { return (uint32_t) uint_(4); }
+  auto i32 () -> int32_t { return (int32_t) u32(); }
+  auto i64 () -> int64_t { return (int64_t) uint_(8); }
+  /// gets a view of the string in the buffer.
+  auto string () -> std::string_view {
+    size_t length = u16();
+    if (!has_(length)) return {};
+    pos_ += length;
+    return buf_.substr(pos_ - length, length);
+  }
+  auto date () -> Date {
+    int month = u8();
+    int day = u8();
+    return Date(month, day);
+  }
+  auto instant () -> Instant {
+    int hour = u8();
+    int minute = u8();
+    return Instant(hour, minute);
+  }
+
+  /// checks if nothing is read past the end.
+  auto ok () const -> bool { return ok_; }
+  /// checks if the whole buffer is read, and nothing more.
+  auto done () const -> bool { return ok_ && pos_ == buf_.length(); }
+
+ private:
+  std::string_view buf_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+
+  auto has_ (size_t n) -> bool {
+    if (pos_ + n > buf_.length()) ok_ = false;
+    return ok_;
+  }
+  auto uint_ (int n) -> uint64_t {
+    if (!has_(n)) return 0;
+    uint64_t x = 0;
+    for (int i = 0; i < n; ++i) {
+      x |= (uint64_t) (unsigned char) buf_[pos_ + i] << (8 * i);
+    }
+    pos_ += n;
+    return x;
+  }
+};
+
+} // namespace ticket::binary
+
+#endif // TICKET_LIB_BINARY_H_
@@ -0,0 +1,52 @@
+#include "binary.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "datetime.h"
+#include "writer.h"
+
+using ticket::Date, ticket::Instant, ticket::Writer;
+using ticket::binary::Reader;
+
+auto main () -> int {
+  std::string buf;
+  {
+    Writer out(-1);
+    out.capture(&buf);
+    out.u8(200).u16(65535).i32(-2).u32(0x12345678).string("abc")
+      .u8(8).u8(17).u8(23).u8(5).i64(-(1LL << 40));
+    out.rawDateTime(Date(6, 30), Instant(23, 0) + ticket::Duration(90));
+    out.capture(nullptr);
+  }
+  assert(buf.length() == 1 + 2 + 4 + 4 + 5 + 4 + 8 + 4);
+  assert(buf.substr(7, 4) == "\x78\x56\x34\x12");
+
+  Reader in(buf);
+  assert(in.u8() == 200);
+  assert(in.u16() == 65535);
+  assert(in.i32() == -2);
+  assert(in.u32() == 0x12345678);
+  assert(in.string() == "abc");
+  assert(in.date() == Date(8, 17));
+  assert(in.instant() == Instant(23, 5));
+  assert(in.i64() == -(1LL << 40));
+  assert(in.date() == Date(7, 1));
+  assert(in.instant() == Instant(0, 30));
+  assert(in.done());
+
+  // reading past the end.
+  Reader truncated(std::string_view(buf).substr(0, 12));
+  truncated.u8();
+  truncated.u16();
+  truncated.i32();
+  assert(truncated.ok() && !truncated.done());
+  assert(truncated.string() == "");
+  assert(!truncated.ok());
+  assert(truncated.u32() == 0);
+  return 0;
+}
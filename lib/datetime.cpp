@@ -20,11 +20,11 @@ auto setNumber (char *str, int i) -> void {
   str[1] = i % 10 + '0';
 }
 constexpr int kSzFormat = 6;
+/// writes "aa<sep>bb", without a trailing zero.
 auto setNumbers (char *str, int a, int b, char sep) -> void {
   setNumber(str, a); // 0, 1
   str[2] = sep;
   setNumber(&str[3], b); // 3, 4
-  str[5] = '\0';
 }
 
 constexpr int daysInYear[] = { 0, 30, 61, 92 };
@@ -94,9 +94,13 @@ auto Date::date () const -> int {
 }
 Date::operator std::string () const {
   char buf[kSzFormat];
+  format(buf);
+  buf[kFormatLength] = '\0';
+  return buf;
+}
+auto Date::format (char *buf) const -> void {
   auto [ month, date ] = mdFromDays(days_);
   setNumbers(buf, month, date, '-');
-  return buf;
 }
 
 auto Date::operator+ (int dt) const -> Date {
@@ -150,9 +154,13 @@ auto Instant::withoutOverflow () const -> Instant {
 
 Instant::operator std::string () const {
   char buf[kSzFormat];
+  format(buf);
+  buf[kFormatLength] = '\0';
+  return buf;
+}
+auto Instant::format (char *buf) const -> void {
   auto [ _, hours, minutes ] = dhmFromMinutes(minutes_);
   setNumbers(buf, hours, minutes, ':');
-  return buf;
 }
 
 auto Instant::operator+ (Duration dt) const -> Instant {
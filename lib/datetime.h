@@ -29,6 +29,10 @@ class Date : public Comparable<Date> {
   auto date () const -> int;
   /// gets a MM-DD representation of the Date.
   operator std::string () const;
+  static constexpr int kFormatLength = 5;
+  /// writes the MM-DD representation to buf, without a
+  /// trailing zero.
+  auto format (char *buf) const -> void;
   /**
    * @brief calculates a date dt days after this Date.
    * (06-04 + 3 == 06-07)
@@ -118,6 +122,10 @@ class Instant : public Comparable<Instant> {
   auto minute () const -> int;
   /// gets an HH:MM representation of the Instant.
   operator std::string () const;
+  static constexpr int kFormatLength = 5;
+  /// writes the HH:MM representation to buf, without a
+  /// trailing zero.
+  auto format (char *buf) const -> void;
   auto operator+ (Duration dt) const -> Instant;
   auto operator- (Duration dt) const -> Instant;
   auto operator- (Instant rhs) const -> Duration;
@@ -0,0 +1,279 @@
+#ifndef TICKET_LIB_FILE_APPEND_LOG_H_
+#define TICKET_LIB_FILE_APPEND_LOG_H_
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "exception.h"
+#include "utility.h"
+#include "vector.h"
+
+namespace ticket::file {
+
+/**
+ * @brief An append-only file of variable-length records.
+ *
+ * Records are pushed at the end and read or popped from the
+ * end, i.e. it is a stack on disk. Every record is followed
+ * by its length, so that the file can be scanned backwards.
+ * Both the appends and the backward scans go through
+ * buffers of kBlock bytes, not through the page cache of
+ * File.
+ *
+ * The records are stored in segment files of about
+ * szSegment bytes each, named filename.<id>. Every record
+ * is pushed with a nondecreasing key, and forget() deletes
+ * the oldest segments whose keys are all below a horizon.
+ * The indices and the positions of the records keep
+ * counting from the first record ever pushed, so that they
+ * stay valid after the old segments are gone.
+ *
+ * The number of records, the end of the data and the list
+ * of segments are kept in filename, which is written back
+ * on destruction.
+ */
+class AppendLog {
+ public:
+  /// the maximum length of a record.
+  static constexpr size_t kMaxRecord = 65535;
+  static constexpr size_t kDefaultSegment = 1 << 22;
+
+  AppendLog (const char *filename, size_t szSegment = kDefaultSegment)
+    : filename_(filename), szSegment_(szSegment) {
+    std::ifstream manifest(filename_, std::ios::binary);
+    Header header;
+    if (manifest.is_open()
+      && manifest.read((char *) &header, sizeof(header))) {
+      count_ = header.count;
+      end_ = header.end;
+      nextId_ = header.nextId;
+      for (int i = 0; i < header.segments; ++i) {
+        Segment segment;
+        manifest.read((char *) &segment, sizeof(segment));
+        segments_.push_back(segment);
+      }
+    }
+    if (segments_.empty()) segments_.push_back({ nextId_++, 0, 0, 0 });
+    open_(true);
+    writeBuf_ = new char[kBlock];
+    readBuf_ = new char[kBlock];
+  }
+  AppendLog (const AppendLog &) = delete;
+  auto operator= (const AppendLog &) -> AppendLog & = delete;
+  ~AppendLog () {
+    close_();
+    std::ofstream manifest(filename_, std::ios::binary);
+    Header header { count_, end_, nextId_, (int) segments_.size() };
+    manifest.write((const char *) &header, sizeof(header));
+    for (const auto &segment : segments_) {
+      manifest.write((const char *) &segment, sizeof(segment));
+    }
+    delete[] writeBuf_;
+    delete[] readBuf_;
+  }
+
+  /**
+   * @brief appends a record of n bytes.
+   *
+   * @param key not less than the keys of the records before.
+   */
+  auto push (const void *buf, size_t n, int key) -> void {
+    TICKET_ASSERT(n <= kMaxRecord);
+    if (end_ - segments_.back().begin >= szSegment_) {
+      // seals the current segment and starts a new one.
+      close_();
+      segments_.push_back({ nextId_++, count_, end_, key });
+      open_(false);
+    }
+    // the bytes after end_ are overwritten from now on.
+    if (readStart_ + readLength_ > end_) {
+      readLength_ = end_ > readStart_ ? end_ - readStart_ : 0;
+    }
+    if (writeLength_ + n + sizeof(Length) > kBlock) flush_();
+    Length length = n;
+    memcpy(writeBuf_ + writeLength_, buf, n);
+    memcpy(writeBuf_ + writeLength_ + n, &length, sizeof(length));
+    writeLength_ += n + sizeof(length);
+    end_ += n + sizeof(length);
+    ++count_;
+    last_().lastKey = key;
+  }
+  /**
+   * @brief reads the last record.
+   *
+   * the view is valid until the next operation on the log.
+   */
+  auto back () -> std::string_view {
+    TICKET_ASSERT(!empty());
+    flush_();
+    Length length;
+    memcpy(&length, read_(end_ - sizeof(length), sizeof(length)),
+      sizeof(length));
+    auto begin = end_ - sizeof(length) - length;
+    return { read_(begin, length), length };
+  }
+  /// removes the last record.
+  auto pop () -> void {
+    end_ -= back().length() + sizeof(Length);
+    --count_;
+    // the last segment is never left empty, so that back()
+    // reads from the open file.
+    if (count_ == segments_.back().first && segments_.size() > 1) {
+      removeLast_();
+    }
+  }
+
+  /// checks if there are no records left, forgotten or not.
+  auto empty () const -> bool { return count_ == segments_.front().first; }
+  /// gets the number of records ever pushed and not popped.
+  auto size () const -> size_t { return count_; }
+  /// gets the position right after the last record.
+  auto end () const -> size_t { return end_; }
+  /// gets the number of segments on disk.
+  auto segments () const -> size_t { return segments_.size(); }
+  /**
+   * @brief keeps only the first count records.
+   *
+   * @param end the position right after the last record
+   *   kept, as returned by end() at that time.
+   */
+  auto truncate (size_t count, size_t end) -> void {
+    TICKET_ASSERT(count <= count_ && end <= end_);
+    TICKET_ASSERT(count >= segments_.front().first);
+    flush_();
+    count_ = count;
+    end_ = end;
+    while (segments_.size() > 1 && segments_.back().first >= count_) {
+      removeLast_();
+    }
+    readLength_ = 0;
+  }
+  /// removes all records.
+  auto clear () -> void {
+    close_();
+    for (const auto &segment : segments_) {
+      std::filesystem::remove(segmentName_(segment.id));
+    }
+    segments_.clear();
+    count_ = end_ = 0;
+    segments_.push_back({ nextId_++, 0, 0, 0 });
+    open_(false);
+  }
+  /**
+   * @brief deletes the oldest segments whose records all
+   * have keys <= key.
+   *
+   * the last segment is always kept. The records forgotten
+   * must not be read, popped or truncated to afterwards.
+   */
+  auto forget (int key) -> void {
+    size_t n = 0;
+    while (n + 1 < segments_.size() && segments_[n].lastKey <= key) {
+      std::filesystem::remove(segmentName_(segments_[n].id));
+      ++n;
+    }
+    if (n == 0) return;
+    Vector<Segment> rest;
+    for (size_t i = n; i < segments_.size(); ++i) {
+      rest.push_back(segments_[i]);
+    }
+    segments_ = rest;
+  }
+
+ private:
+  struct Header {
+    size_t count;
+    size_t end;
+    int nextId;
+    int segments;
+  };
+  struct Segment {
+    int id;
+    /// the index of its first record.
+    size_t first;
+    /// the position of its first byte.
+    size_t begin;
+    /// the key of its last record.
+    int lastKey;
+  };
+  using Length = unsigned short;
+  static_assert(kMaxRecord <= (Length) -1);
+  static constexpr size_t kBlock = 1 << 17;
+  static_assert(kBlock >= kMaxRecord + sizeof(Length));
+
+  std::string filename_;
+  size_t szSegment_;
+  /// the last segment, the only one open.
+  std::fstream file_;
+  Vector<Segment> segments_;
+  int nextId_ = 0;
+  size_t count_ = 0;
+  size_t end_ = 0;
+  /// the last writeLength_ bytes before end_.
+  char *writeBuf_;
+  size_t writeLength_ = 0;
+  /// the bytes [readStart_, readStart_ + readLength_).
+  char *readBuf_;
+  size_t readStart_ = 0;
+  size_t readLength_ = 0;
+
+  auto last_ () -> Segment & { return segments_[segments_.size() - 1]; }
+  auto segmentName_ (int id) const -> std::string {
+    return filename_ + "." + std::to_string(id);
+  }
+  /// opens the last segment, keeping its content if keep.
+  auto open_ (bool keep) -> void {
+    auto name = segmentName_(segments_.back().id);
+    // creates the file if it does not exist.
+    std::ofstream(name, keep ? std::ios::app | std::ios::binary
+      : std::ios::trunc | std::ios::binary);
+    file_.open(name, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file_.is_open()) {
+      throw IoException("Unable to open append log");
+    }
+    readLength_ = 0;
+  }
+  /// flushes and closes the last segment, dropping the
+  /// bytes after end_.
+  auto close_ () -> void {
+    flush_();
+    file_.close();
+    std::filesystem::resize_file(segmentName_(segments_.back().id),
+      end_ - segments_.back().begin);
+  }
+  /// deletes the last segment and opens the one before.
+  auto removeLast_ () -> void {
+    file_.close();
+    std::filesystem::remove(segmentName_(segments_.back().id));
+    segments_.pop_back();
+    open_(true);
+  }
+  auto flush_ () -> void {
+    if (writeLength_ == 0) return;
+    file_.seekp(end_ - writeLength_ - segments_.back().begin);
+    file_.write(writeBuf_, writeLength_);
+    writeLength_ = 0;
+  }
+  /// gets the n bytes at pos in the last segment, which
+  /// must be flushed.
+  auto read_ (size_t pos, size_t n) -> const char * {
+    if (pos < readStart_ || pos + n > readStart_ + readLength_) {
+      // read the block ending at pos + n, as the log is
+      // mostly read backwards.
+      auto begin = segments_.back().begin;
+      readStart_ = pos + n > begin + kBlock ? pos + n - kBlock : begin;
+      readLength_ = pos + n - readStart_;
+      file_.seekg(readStart_ - begin);
+      file_.read(readBuf_, readLength_);
+      TICKET_ASSERT(file_.good());
+    }
+    return readBuf_ + (pos - readStart_);
+  }
+};
+
+} // namespace ticket::file
+
+#endif // TICKET_LIB_FILE_APPEND_LOG_H_
@@ -0,0 +1,83 @@
+#include "file/append-log.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <string>
+
+using ticket::file::AppendLog;
+
+auto recordOf (int i) -> std::string {
+  // records of different lengths, some longer than others
+  // together in a block.
+  return std::to_string(i) + std::string(i % 300, 'a' + i % 26);
+}
+
+auto main () -> int {
+  remove("test.log");
+  size_t half = 0;
+  {
+    AppendLog log("test.log");
+    assert(log.size() == 0);
+    for (int i = 0; i < 5000; ++i) {
+      if (i == 2500) half = log.end();
+      auto record = recordOf(i);
+      log.push(record.data(), record.length(), i);
+    }
+    assert(log.size() == 5000);
+    for (int i = 4999; i >= 4000; --i) {
+      assert(log.back() == recordOf(i));
+      log.pop();
+    }
+    // overwrites the popped records.
+    for (int i = 4000; i < 4500; ++i) {
+      auto record = recordOf(i);
+      log.push(record.data(), record.length(), i);
+    }
+  }
+  {
+    AppendLog log("test.log");
+    assert(log.size() == 4500);
+    assert(log.back() == recordOf(4499));
+    log.truncate(2500, half);
+    for (int i = 2499; i >= 0; --i) {
+      assert(log.back() == recordOf(i));
+      log.pop();
+    }
+    assert(log.size() == 0);
+    auto record = recordOf(42);
+    log.push(record.data(), record.length(), 0);
+    assert(log.back() == record);
+  }
+  {
+    // small segments, and the keys are i / 10.
+    AppendLog log("test.log", 4096);
+    log.clear();
+    for (int i = 0; i < 3000; ++i) {
+      auto record = recordOf(i);
+      log.push(record.data(), record.length(), i / 10);
+    }
+    auto segments = log.segments();
+    assert(segments > 100);
+    log.forget(150);
+    assert(log.segments() < segments);
+    assert(log.size() == 3000);
+    for (int i = 2999; i >= 1510; --i) {
+      assert(log.back() == recordOf(i));
+      log.pop();
+    }
+    // forgetting everything keeps the last segment.
+    log.forget(1000);
+    assert(log.segments() == 1);
+    assert(log.back() == recordOf(1509));
+  }
+  {
+    AppendLog log("test.log", 4096);
+    assert(log.size() == 1510);
+    assert(log.back() == recordOf(1509));
+    log.clear();
+    assert(log.empty() && log.segments() == 1);
+  }
+  remove("test.log");
+  return 0;
+}
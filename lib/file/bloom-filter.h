@@ -0,0 +1,102 @@
+#ifndef TICKET_LIB_FILE_BLOOM_FILTER_H_
+#define TICKET_LIB_FILE_BLOOM_FILTER_H_
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "utility.h"
+
+namespace ticket::file {
+
+/**
+ * @brief A persistent counting Bloom filter on hashes.
+ *
+ * It tells for most absent keys that they are definitely
+ * absent, without touching the disk. Each slot is a counter
+ * rather than a bit, so that keys can be removed; once a
+ * counter saturates it is never decremented again, which
+ * only costs some false positives.
+ *
+ * The counters are read from filename on construction and
+ * written back on destruction. The file is removed once
+ * read, so that a run ending without the destructor (a
+ * crash, or SIGKILL) leaves no filter older than the keys
+ * written since. If the file does not exist, loaded() is
+ * false and the owner is expected to rebuild the filter by
+ * inserting every key.
+ */
+template <size_t kLogSize = 19, int kHashes = 4>
+class BloomFilter {
+ public:
+  BloomFilter (const char *filename) : filename_(filename) {
+    counters_ = new unsigned char[kSize];
+    std::ifstream file(filename_, std::ios::binary);
+    if (file.is_open()) {
+      file.read((char *) counters_, kSize);
+      loaded_ = file.gcount() == kSize;
+      file.close();
+      ::remove(filename_.c_str());
+    }
+    if (!loaded_) clear();
+  }
+  BloomFilter (const BloomFilter &) = delete;
+  auto operator= (const BloomFilter &) -> BloomFilter & = delete;
+  ~BloomFilter () {
+    std::ofstream file(filename_, std::ios::binary);
+    if (file.is_open()) file.write((const char *) counters_, kSize);
+    delete[] counters_;
+  }
+
+  /// adds a key to the filter.
+  auto insert (size_t hash) -> void {
+    for (int i = 0; i < kHashes; ++i) {
+      auto &counter = counters_[slot_(hash, i)];
+      if (counter != kSaturated) ++counter;
+    }
+  }
+  /**
+   * @brief removes a key from the filter.
+   *
+   * the key must have been inserted before.
+   */
+  auto remove (size_t hash) -> void {
+    for (int i = 0; i < kHashes; ++i) {
+      auto &counter = counters_[slot_(hash, i)];
+      TICKET_ASSERT(counter != 0);
+      if (counter != kSaturated) --counter;
+    }
+  }
+  /// false if the key is definitely not in the filter.
+  auto mayContain (size_t hash) const -> bool {
+    for (int i = 0; i < kHashes; ++i) {
+      if (counters_[slot_(hash, i)] == 0) return false;
+    }
+    return true;
+  }
+  /// removes all keys.
+  auto clear () -> void {
+    memset(counters_, 0, kSize);
+  }
+  /// checks if the filter is read from its file.
+  auto loaded () const -> bool { return loaded_; }
+
+ private:
+  static constexpr size_t kSize = 1ULL << kLogSize;
+  static constexpr unsigned char kSaturated = 255;
+  std::string filename_;
+  unsigned char *counters_;
+  bool loaded_ = false;
+
+  /// double hashing, with the odd step derived from the
+  /// high bits of the hash.
+  static auto slot_ (size_t hash, int i) -> size_t {
+    size_t step = ((hash >> 32) | (hash << 32)) | 1;
+    return (hash + i * step) & (kSize - 1);
+  }
+};
+
+} // namespace ticket::file
+
+#endif // TICKET_LIB_FILE_BLOOM_FILTER_H_
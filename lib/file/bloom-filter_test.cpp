@@ -0,0 +1,42 @@
+#include "file/bloom-filter.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <functional>
+#include <string>
+
+using ticket::file::BloomFilter;
+
+auto hashOf (int i) -> size_t {
+  return std::hash<std::string>()("key" + std::to_string(i));
+}
+
+auto main () -> int {
+  remove("test.bloom");
+  {
+    BloomFilter<> filter("test.bloom");
+    assert(!filter.loaded());
+    for (int i = 0; i < 10000; ++i) filter.insert(hashOf(i));
+    for (int i = 0; i < 10000; ++i) assert(filter.mayContain(hashOf(i)));
+    int falsePositives = 0;
+    for (int i = 10000; i < 20000; ++i) {
+      if (filter.mayContain(hashOf(i))) ++falsePositives;
+    }
+    assert(falsePositives < 100);
+    for (int i = 0; i < 5000; ++i) filter.remove(hashOf(i));
+    for (int i = 5000; i < 10000; ++i) assert(filter.mayContain(hashOf(i)));
+  }
+  {
+    BloomFilter<> filter("test.bloom");
+    assert(filter.loaded());
+    for (int i = 5000; i < 10000; ++i) assert(filter.mayContain(hashOf(i)));
+    // a run dying now must not leave the counters behind.
+    BloomFilter<> crashed("test.bloom");
+    assert(!crashed.loaded());
+    filter.clear();
+    assert(!filter.mayContain(hashOf(5000)));
+  }
+  remove("test.bloom");
+  return 0;
+}
@@ -74,6 +74,23 @@ class BpTree {
   auto findMany (const KeyType &key) -> Vector<ValueType> {
     return findMany_(key, Node::root(*this));
   }
+  /**
+   * @brief finds at most limit entries with the given key,
+   * skipping the first offset ones in CmpValue order.
+   *
+   * it descends the tree once and then scans the leaves,
+   * skipping whole leaves where possible.
+   */
+  auto findMany (const KeyType &key, int offset, int limit)
+    -> Vector<ValueType> {
+    Vector<ValueType> res;
+    if (limit <= 0) return res;
+    auto cursor = seek_(key, Node::root(*this));
+    if (!cursor) return res;
+    addValuesToVectorPaged_(res, key, cursor->first, cursor->second,
+                            offset, limit);
+    return res;
+  }
   /// finds all entries.
   auto findAll () -> Vector<ticket::Pair<KeyType, ValueType>> {
     return findAll_(Node::root(*this));
@@ -398,8 +415,26 @@ class BpTree {
     for (; i < node.length() && cmpKey_.equals(node.entries()[i].key, key); ++i) vec.push_back(node.entries()[i].value);
     if (i == node.length() && node.next() != 0) addValuesToVectorForAllKeyFrom_(vec, key, Node::get(file_, node.next()), 0);
   }
+  auto addValuesToVectorPaged_ (Vector<ValueType> &vec, const KeyType &key, Node node, int first, int offset, int limit) -> void {
+    int length = node.length();
+    int i = first;
+    if (offset >= length - first && cmpKey_.equals(node.entries()[length - 1].key, key)) {
+      // the whole rest of this node is skipped.
+      offset -= length - first;
+      i = length;
+    }
+    for (; i < length && cmpKey_.equals(node.entries()[i].key, key); ++i) {
+      if (offset > 0) {
+        --offset;
+        continue;
+      }
+      vec.push_back(node.entries()[i].value);
+      if (--limit == 0) return;
+    }
+    if (i == length && node.next() != 0) addValuesToVectorPaged_(vec, key, Node::get(file_, node.next()), 0, offset, limit);
+  }
   auto addEntriesToVector_ (Vector<ticket::Pair<KeyType, ValueType>> &vec, Node node) -> void {
-    for (int i = 0; i < node.length(); ++i) vec.emplace_back(node.entries()[i].key, node.entries()[i].value);
+    for (int i = 0; i < node.length(); ++i) vec.push_back({ node.entries()[i].key, node.entries()[i].value });
     if (node.next() != 0) addEntriesToVector_(vec, Node::get(file_, node.next()));
   }
   auto findFirstChildWithKey_ (const KeyType &key, Node &node) -> ticket::Pair<Node, Optional<Node>> {
@@ -507,6 +542,25 @@ class BpTree {
     addValuesToVectorForAllKeyFrom_(res, key, node, ix);
     return res;
   }
+  /// finds the record node and the index of the first entry with the given key.
+  auto seek_ (const KeyType &key, Node node) -> Optional<ticket::Pair<Node, int>> {
+    if (node.type != kRecord) {
+      if (node.length() == 0) return unit;
+      auto [ car, cdr ] = findFirstChildWithKey_(key, node);
+      auto res = seek_(key, car);
+      if (res || !cdr) return res;
+      return seek_(key, *cdr);
+    }
+    size_t ix = upperBound(
+      node.entries().content,
+      node.entries().content + node.length(),
+      key,
+      Less<KeyComparatorLess_>()
+    ) - node.entries().content;
+    if (ix >= node.length()) return unit;
+    if (!cmpKey_.equals(node.entries()[ix].key, key)) return unit;
+    return ticket::Pair<Node, int> { node, (int) ix };
+  }
   auto findAll_ (Node node) -> Vector<ticket::Pair<KeyType, ValueType>> {
     if (node.type != kRecord) {
       if (node.length() == 0) return {};
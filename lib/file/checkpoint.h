@@ -0,0 +1,110 @@
+#ifndef TICKET_LIB_FILE_CHECKPOINT_H_
+#define TICKET_LIB_FILE_CHECKPOINT_H_
+
+/**
+ * @brief Copy-on-write checkpoints of all the files.
+ *
+ * Time is split into epochs, and epoch k begins when
+ * checkpoint k is taken. On the first write to a page in
+ * epoch k, the old content of the page is appended to the
+ * journal of its file. Restoring checkpoint k applies the
+ * journal records of epochs >= k from the newest to the
+ * oldest, so that every page ends up with its content at
+ * the beginning of epoch k. Epoch 0 is not journaled.
+ *
+ * Dropping checkpoint k without restoring it merges epochs
+ * >= k into epoch k - 1, as their records are still needed
+ * to restore the earlier checkpoints. Once the checkpoints
+ * before k are forgotten, the records of epochs < k are
+ * never read again and are compacted away.
+ */
+namespace ticket::file::checkpoint {
+
+/// An object taking part in checkpoints.
+class Participant {
+ public:
+  Participant () {
+    next_ = head_;
+    if (head_ != nullptr) head_->prev_ = this;
+    head_ = this;
+  }
+  Participant (const Participant &) = delete;
+  auto operator= (const Participant &) -> Participant & = delete;
+  virtual ~Participant () {
+    if (prev_ != nullptr) prev_->next_ = next_;
+    if (next_ != nullptr) next_->prev_ = prev_;
+    if (head_ == this) head_ = next_;
+  }
+
+  /**
+   * @brief restores the pages to the beginning of the
+   * epoch, and removes the journal records of epochs >=
+   * epoch.
+   */
+  virtual auto restorePages (int /* epoch */) -> void {}
+  /// merges the journal records of epochs >= epoch into
+  /// epoch - 1.
+  virtual auto dropJournal (int /* epoch */) -> void {}
+  /// may remove the journal records of epochs < epoch.
+  virtual auto forgetJournal (int /* epoch */) -> void {}
+  /// called after all participants are restored.
+  virtual auto afterRestore () -> void {}
+
+  /// calls fn on every participant.
+  template <typename Functor>
+  static auto forEach (const Functor &fn) -> void {
+    for (auto p = head_; p != nullptr; p = p->next_) fn(*p);
+  }
+
+ private:
+  Participant *prev_ = nullptr;
+  Participant *next_ = nullptr;
+  static inline Participant *head_ = nullptr;
+};
+
+namespace internal {
+inline int currentEpoch = 0;
+} // namespace internal
+
+/// gets the current epoch.
+inline auto epoch () -> int { return internal::currentEpoch; }
+/// begins a new epoch, i.e. takes a checkpoint.
+inline auto begin (int epoch) -> void {
+  internal::currentEpoch = epoch;
+}
+/**
+ * @brief drops checkpoints >= epoch without restoring them,
+ * and goes back to epoch - 1.
+ */
+inline auto drop (int epoch) -> void {
+  Participant::forEach([epoch] (Participant &p) {
+    p.dropJournal(epoch);
+  });
+  internal::currentEpoch = epoch - 1;
+}
+/**
+ * @brief forgets the checkpoints before epoch, which are
+ * never restored afterwards.
+ */
+inline auto forget (int epoch) -> void {
+  Participant::forEach([epoch] (Participant &p) {
+    p.forgetJournal(epoch);
+  });
+}
+/**
+ * @brief restores checkpoint epoch, drops it and all later
+ * ones, and goes back to epoch - 1.
+ */
+inline auto restore (int epoch) -> void {
+  Participant::forEach([epoch] (Participant &p) {
+    p.restorePages(epoch);
+  });
+  internal::currentEpoch = epoch - 1;
+  Participant::forEach([] (Participant &p) {
+    p.afterRestore();
+  });
+}
+
+} // namespace ticket::file::checkpoint
+
+#endif // TICKET_LIB_FILE_CHECKPOINT_H_
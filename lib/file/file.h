@@ -3,8 +3,12 @@
 #define TICKET_LIB_FILE_FILE_H_
 
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <string>
 
+#include "file/checkpoint.h"
 #include "hashmap.h"
 #include "lru-cache.h"
 #include "utility.h"
@@ -20,10 +24,15 @@ constexpr size_t kDefaultSzChunk = 4096;
  * collection.
  *
  * It is of chunk size of szChunk and has cache powered by
- * HashMap.
+ * HashMap. It keeps a journal of old page contents next to
+ * the file, see checkpoint.h.
+ *
+ * get() may be called from several threads at once, as
+ * long as nothing is written meanwhile; the other methods
+ * are not thread-safe.
  */
 template <typename Meta = Unit, size_t szChunk = kDefaultSzChunk>
-class File {
+class File : public checkpoint::Participant {
  private:
   class Metadata;
  public:
@@ -46,6 +55,9 @@ class File {
 
   /// read n bytes at index into buf.
   auto get (void *buf, size_t index, size_t n) -> void {
+    // a hit still reorders the cache, and a miss moves the
+    // file position.
+    std::lock_guard<std::mutex> lock(mutex_);
     if (auto cached = cache_.get(index)) {
       memcpy(buf, *cached, n);
       return;
@@ -58,6 +70,7 @@ class File {
   /// write n bytes at index from buf.
   auto set (const void *buf, size_t index, size_t n)
     -> void {
+    journalPage_(index);
     cache_.upsert(index, buf, n, true);
   }
   /// @returns the stored index of the object
@@ -104,6 +117,66 @@ class File {
     set(&meta, -1, sizeof(meta));
   }
 
+  auto restorePages (int epoch) -> void override {
+    auto keep = journalLength_();
+    JournalRecord record;
+    restoring_ = true;
+    while (keep > 0) {
+      readRecord_(record, keep - 1);
+      if (record.epoch < epoch) break;
+      set(record.data, record.index, record.length);
+      --keep;
+    }
+    restoring_ = false;
+    truncateJournal_(keep);
+  }
+  auto dropJournal (int epoch) -> void override {
+    // nothing is journaled in epoch 0.
+    if (epoch == 1) {
+      truncateJournal_(0);
+      return;
+    }
+    auto count = journalLength_();
+    JournalRecord record;
+    for (auto i = count; i-- > 0;) {
+      readRecord_(record, i);
+      if (record.epoch < epoch) break;
+      record.epoch = epoch - 1;
+      journal_.seekp(i * sizeof(JournalRecord));
+      journal_.write((const char *) &record.epoch, sizeof(record.epoch));
+    }
+    journaledEpoch_ = -1;
+  }
+  auto forgetJournal (int epoch) -> void override {
+    // the records are sorted by epoch, so the dead ones are a
+    // prefix of the journal.
+    auto count = journalLength_();
+    size_t dead = 0, hi = count;
+    JournalRecord record;
+    while (dead < hi) {
+      auto mid = (dead + hi) / 2;
+      readRecord_(record, mid);
+      if (record.epoch < epoch) {
+        dead = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    // copying the live records is only worth it once they
+    // are no more than the dead ones.
+    if (dead == 0 || dead < count - dead) return;
+    auto tmpName = journalName_ + ".tmp";
+    {
+      std::ofstream tmp(tmpName, std::ios::binary);
+      for (auto i = dead; i < count; ++i) {
+        readRecord_(record, i);
+        tmp.write((const char *) &record, sizeof(record));
+      }
+    }
+    journal_.close();
+    std::filesystem::rename(tmpName, journalName_);
+  }
+
  private:
   struct Metadata {
     size_t next;
@@ -114,8 +187,84 @@ class File {
   };
   static_assert(szChunk > sizeof(Metadata));
 
+  /// the old content of a page, see checkpoint.h.
+  struct JournalRecord {
+    int epoch;
+    int length;
+    size_t index;
+    char data[szChunk];
+  };
+  std::string journalName_;
+  std::fstream journal_;
+  /// the pages already journaled in journaledEpoch_.
+  HashMap<size_t, bool> journaled_;
+  int journaledEpoch_ = -1;
+  bool restoring_ = false;
+
+  auto openJournal_ () -> void {
+    if (journal_.is_open()) return;
+    // creates the file if it does not exist.
+    std::ofstream(journalName_, std::ios::app | std::ios::binary);
+    journal_.open(journalName_,
+      std::ios::in | std::ios::out | std::ios::binary);
+    if (!journal_.is_open()) {
+      throw IoException("Unable to open journal");
+    }
+  }
+  auto journalLength_ () -> size_t {
+    openJournal_();
+    journal_.seekg(0, std::ios::end);
+    return (size_t) journal_.tellg() / sizeof(JournalRecord);
+  }
+  /// keeps only the first count records of the journal.
+  auto truncateJournal_ (size_t count) -> void {
+    if (journalLength_() != count) {
+      journal_.close();
+      std::filesystem::resize_file(
+        journalName_, count * sizeof(JournalRecord));
+    }
+    journaledEpoch_ = -1;
+  }
+  auto readRecord_ (JournalRecord &record, size_t i) -> void {
+    journal_.seekg(i * sizeof(JournalRecord));
+    journal_.read((char *) &record, sizeof(record));
+    TICKET_ASSERT(journal_.good());
+  }
+  /// records the old content of the page before writing it.
+  auto journalPage_ (size_t index) -> void {
+    int epoch = checkpoint::epoch();
+    if (epoch == 0 || restoring_) return;
+    if (journaledEpoch_ != epoch) {
+      journaled_.clear();
+      journaledEpoch_ = epoch;
+    }
+    if (!journaled_.insert({ index, true }).second) return;
+
+    JournalRecord record;
+    record.epoch = epoch;
+    record.index = index;
+    int length;
+    if (auto cached = cache_.get(index, length)) {
+      memcpy(record.data, *cached, length);
+      record.length = length;
+    } else {
+      file_.seekg(offset_(index));
+      file_.read(record.data, szChunk);
+      // the page may be partially written or not exist.
+      record.length = file_.gcount() == 0 ? 0 : szChunk;
+      memset(record.data + file_.gcount(), 0, szChunk - file_.gcount());
+      file_.clear();
+    }
+    // a page that does not exist yet needs no restoring.
+    if (record.length == 0) return;
+    openJournal_();
+    journal_.seekp(0, std::ios::end);
+    journal_.write((const char *) &record, sizeof(record));
+  }
+
   template <typename Functor>
   auto init_ (const char *filename, const Functor &initializer) -> void {
+    journalName_ = std::string(filename) + ".journal";
     bool shouldCreate = false;
     auto testFile = fopen(filename, "r");
     if (testFile == nullptr) {
@@ -164,6 +313,7 @@ class File {
     return (index + 1) * szChunk;
   }
   std::fstream file_;
+  std::mutex mutex_;
   constexpr static int kSzCache_ = 512;
   LruCache<size_t, kSzCache_, BeforeDestroy>
     cache_ { BeforeDestroy{this} };
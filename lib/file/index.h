@@ -1,7 +1,11 @@
 #ifndef TICKET_LIB_FILE_INDEX_H_
 #define TICKET_LIB_FILE_INDEX_H_
 
+#include <string>
+
+#include "file/bloom-filter.h"
 #include "file/bptree.h"
+#include "file/checkpoint.h"
 #include "file/varchar.h"
 #include "optional.h"
 #include "vector.h"
@@ -15,9 +19,11 @@ namespace ticket::file {
  * provides methods to directly retrieve model objects from
  * data files.
  *
- * Model needs to be a subclass of ManagedObject.
+ * Model needs to be a subclass of ManagedObject. Entries of
+ * the same key are ordered by their identifiers with
+ * CmpValue, e.g. Greater<> for newest first.
  */
-template <typename Key, typename Model>
+template <typename Key, typename Model, typename CmpValue = Less<>>
 class Index {
  public:
   /**
@@ -60,6 +66,14 @@ class Index {
   auto findManyId (const Key &key) -> Vector<int> {
     return tree_.findMany(key);
   }
+  /**
+   * @brief finds at most limit IDs of the given key in the
+   * index, skipping the first offset ones.
+   */
+  auto findManyId (const Key &key, int offset, int limit)
+    -> Vector<int> {
+    return tree_.findMany(key, offset, limit);
+  }
   /// checks if the index is empty.
   auto empty () -> bool {
     return tree_.empty();
@@ -71,16 +85,20 @@ class Index {
   }
  private:
   Key Model::*ptr_;
-  BpTree<Key, int> tree_;
+  BpTree<Key, int, Less<>, CmpValue> tree_;
 };
 
 /**
  * @brief Specialization of Index on Varchar.
  *
- * It makes use of hashes to speed up the process.
+ * It makes use of hashes to speed up the process. A Bloom
+ * filter on the hashes, stored next to the index file,
+ * answers most lookups of absent keys without descending
+ * the tree.
  */
-template <size_t maxLength, typename Model>
-class Index<Varchar<maxLength>, Model> {
+template <int maxLength, typename Model, typename CmpValue>
+class Index<Varchar<maxLength>, Model, CmpValue>
+  : public checkpoint::Participant {
  private:
   using Key = Varchar<maxLength>;
  public:
@@ -91,37 +109,54 @@ class Index<Varchar<maxLength>, Model> {
    * @param datafile the main file where data is stored.
    */
   Index (Key Model::*ptr, const char *filename)
-    : ptr_(ptr), tree_(filename) {}
+    : ptr_(ptr), tree_(filename),
+      filter_((std::string(filename) + ".bloom").c_str()) {
+    if (!filter_.loaded()) rebuildFilter_();
+  }
   /// inserts an object into the index.
   auto insert (const Model &model) -> void {
     TICKET_ASSERT(model.id() != -1);
     tree_.insert((model.*ptr_).hash(), model.id());
+    filter_.insert((model.*ptr_).hash());
   }
   /// removes an object from the index.
   auto remove (const Model &model) -> void {
     TICKET_ASSERT(model.id() != -1);
     tree_.remove((model.*ptr_).hash(), model.id());
+    filter_.remove((model.*ptr_).hash());
   }
   /// finds one Model in the index.
   auto findOne (const Key &key) -> Optional<Model> {
+    if (!filter_.mayContain(key.hash())) return unit;
     auto id = tree_.findOne(key.hash());
     if (!id) return unit;
     return Model::get(*id);
   }
   /// finds one identifier in the index.
   auto findOneId (const Key &key) -> Optional<int> {
+    if (!filter_.mayContain(key.hash())) return unit;
     return tree_.findOne(key.hash());
   }
   /// finds all Models of the given key in the index.
   auto findMany (const Key &key) -> Vector<Model> {
-    Vector<Model> res;
+    if (!filter_.mayContain(key.hash())) return {};
     auto ids = tree_.findMany(key.hash());
     return ids.map(Model::get);
   }
   /// finds all IDs of the given keys in the index.
   auto findManyId (const Key &key) -> Vector<int> {
+    if (!filter_.mayContain(key.hash())) return {};
     return tree_.findMany(key.hash());
   }
+  /**
+   * @brief finds at most limit IDs of the given key in the
+   * index, skipping the first offset ones.
+   */
+  auto findManyId (const Key &key, int offset, int limit)
+    -> Vector<int> {
+    if (!filter_.mayContain(key.hash())) return {};
+    return tree_.findMany(key.hash(), offset, limit);
+  }
   /// checks if the index is empty.
   auto empty () -> bool {
     return tree_.empty();
@@ -130,10 +165,24 @@ class Index<Varchar<maxLength>, Model> {
   /// deletes all entries.
   auto truncate () -> void {
     tree_.truncate();
+    filter_.clear();
+  }
+
+  /// the tree may have changed under the filter.
+  auto afterRestore () -> void override {
+    rebuildFilter_();
   }
  private:
   Key Model::*ptr_;
-  BpTree<size_t, int> tree_;
+  BpTree<size_t, int, Less<>, CmpValue> tree_;
+  BloomFilter<> filter_;
+
+  auto rebuildFilter_ () -> void {
+    filter_.clear();
+    for (const auto &entry : tree_.findAll()) {
+      filter_.insert(entry.first);
+    }
+  }
 };
 
 } // namespace ticket::file
@@ -4,6 +4,8 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 #include "exception.h"
 
@@ -24,18 +26,15 @@ struct Varchar {
  public:
   static constexpr int kMaxLength = maxLength;
   Varchar () { content[0] = '\0'; }
-  Varchar (const std::string &s) {
+  Varchar (std::string_view s) {
     if (s.length() > maxLength) {
       throw Overflow("Varchar length overflow");
     }
-    strncpy(content, s.c_str(), maxLength + 1);
-  }
-  Varchar (const char *cstr) : Varchar(std::string(cstr)) {
-    if (strlen(cstr) > maxLength) {
-      throw Overflow("Varchar length overflow");
-    }
-    strncpy(content, cstr, maxLength + 1);
+    memcpy(content, s.data(), s.length());
+    content[s.length()] = '\0';
   }
+  Varchar (const std::string &s) : Varchar(std::string_view(s)) {}
+  Varchar (const char *cstr) : Varchar(std::string_view(cstr)) {}
 
   template<int A>
   Varchar (const Varchar<A> &that) { *this = that; }
@@ -45,6 +44,10 @@ struct Varchar {
   [[nodiscard]] auto str () const -> std::string {
     return std::string(*this);
   }
+  /// the content without copying, valid as long as this.
+  [[nodiscard]] auto view () const -> std::string_view {
+    return content;
+  }
 
   auto length () const -> int {
     return strlen(content);
@@ -3,178 +3,190 @@
 
 // only for std::equal_to<T> and std::hash<T>
 #include <functional>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "allocator.h"
 #include "exception.h"
 #include "utility.h"
 
-#ifdef DEBUG
-#include <iostream>
-#endif
-
 namespace ticket {
 
 #include "internal/rehash.inc"
 
+namespace internal {
+
+/**
+ * @brief The control bytes of 16 consecutive slots of a
+ * HashMap, compared all at once.
+ *
+ * A control byte is kEmpty, or the low 7 bits of the hash
+ * of the key in the slot. The matches are returned as a bit
+ * mask, bit i standing for the i-th slot.
+ */
+class ControlGroup {
+ public:
+  static constexpr int kWidth = 16;
+  static constexpr int8_t kEmpty = -128;
+
+#ifdef __SSE2__
+  explicit ControlGroup (const int8_t *ctrl)
+    : ctrl_(_mm_loadu_si128((const __m128i *) ctrl)) {}
+  /// finds the slots whose control byte is h2.
+  auto match (int8_t h2) const -> uint32_t {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2)));
+  }
+  /// finds the empty slots, the only ones with the sign bit.
+  auto matchEmpty () const -> uint32_t {
+    return _mm_movemask_epi8(ctrl_);
+  }
+
+ private:
+  __m128i ctrl_;
+#else
+  explicit ControlGroup (const int8_t *ctrl) {
+    memcpy(ctrl_, ctrl, kWidth);
+  }
+  auto match (int8_t h2) const -> uint32_t {
+    uint32_t bits = 0;
+    for (int i = 0; i < kWidth; ++i) {
+      bits |= (uint32_t) (ctrl_[i] == h2) << i;
+    }
+    return bits;
+  }
+  auto matchEmpty () const -> uint32_t { return match(kEmpty); }
+
+ private:
+  int8_t ctrl_[kWidth];
+#endif
+};
+
+} // namespace internal
+
 /**
- * @brief An unordered hash-based map.
+ * @brief A transparent hash of strings.
  *
- * In HashMap, iteration ordering is differ from map,
- * which is the order in which keys were inserted into the map.
- * You should maintain a doubly-linked list running through all
- * of its entries to keep the correct iteration order.
+ * Used with std::equal_to<>, it allows looking up a
+ * HashMap keyed by std::string with a std::string_view or a
+ * const char * without constructing a std::string.
+ */
+struct StringHash {
+  using is_transparent = void;
+  auto operator() (std::string_view str) const -> size_t {
+    return std::hash<std::string_view>()(str);
+  }
+};
+
+/**
+ * @brief An unordered hash-based map in a flat table.
+ *
+ * The elements are stored in one array of slots, probed
+ * linearly from the slot given by their hash. Next to it
+ * lies an array of control bytes, one per slot, holding 7
+ * more bits of the hash, so that a lookup compares 16 slots
+ * at a time (see internal::ControlGroup) and only compares
+ * the keys whose control bytes match. The table is at most
+ * 3/4 full, and doubles when it would be fuller. Erasing
+ * shifts the rest of the probe sequence back into the hole,
+ * so there are no tombstones, and lookups never slow down
+ * after erasures.
+ *
+ * By default, the iteration order is that of the slots. If
+ * kOrdered, a doubly-linked list of slot indices runs
+ * through the elements in the order in which they were
+ * inserted; re-inserting a key does not change it.
  *
- * Note that insertion order is not affected if a key is re-inserted
- * into the map.
+ * The elements move within the table: inserting may
+ * invalidate all pointers, references and iterators to the
+ * elements, and erasing those to the other elements.
+ *
+ * The table comes from Alloc (see allocator.h).
  */
 template <
   typename Key,
   typename Value,
   typename Hash = std::hash<Key>,
-  typename Equal = std::equal_to<Key>
+  typename Equal = std::equal_to<Key>,
+  bool kOrdered = false,
+  typename Alloc = HeapAllocator
 > class HashMap {
- private:
-  struct ListNode;
-  struct Node;
  public:
   using value_type = Pair<const Key, Value>;
 
-  class const_iterator;
-  class iterator {
+ private:
+  template <bool kConst>
+  class Iterator {
+    using Home = std::conditional_t<kConst, const HashMap, HashMap>;
    public:
     using difference_type = std::ptrdiff_t;
-    using value_type = HashMap::value_type;
+    using value_type = std::conditional_t<
+      kConst, const HashMap::value_type, HashMap::value_type>;
     using pointer = value_type *;
     using reference = value_type &;
-    using iterator_category = std::output_iterator_tag;
-
-    iterator () = default;
-    iterator (ListNode *node, HashMap *home) : node_(node), home_(home) {}
-    auto operator++ (int) -> iterator {
-      if (node_ == &home_->pivot_) throw Exception("invalid state");
-      auto node = node_;
-      node_ = node_->next_;
-      return { node, home_ };
-    }
-    auto operator++ () -> iterator & {
-      if (node_ == &home_->pivot_) throw Exception("invalid state");
-      node_ = node_->next_;
-      return *this;
-    }
-    auto operator-- (int) -> iterator {
-      if (node_ == home_->pivot_.next_) throw Exception("invalid state");
-      auto node = node_;
-      node_ = node_->prev_;
-      return { node, home_ };
-    }
-    auto operator-- () -> iterator & {
-      if (node_ == home_->pivot_.next_) throw Exception("invalid state");
-      node_ = node_->prev_;
-      return *this;
-    }
-    auto operator* () const -> reference {
-      return node_->self->value;
-    }
-    auto operator== (const iterator &rhs) const -> bool {
-      return node_ == rhs.node_;
-    }
-    auto operator== (const const_iterator &rhs) const -> bool {
-      return node_ == rhs.node_;
-    }
-    auto operator!= (const iterator &rhs) const -> bool {
-      return !(*this == rhs);
-    }
-    auto operator!= (const const_iterator &rhs) const -> bool {
-      return !(*this == rhs);
-    }
-    auto operator-> () const noexcept -> pointer {
-      return &**this;
-    }
-   private:
-    ListNode *node_;
-    HashMap *home_;
-    friend class const_iterator;
-    friend class HashMap;
-  };
+    using iterator_category = std::forward_iterator_tag;
 
-  class const_iterator {
-   public:
-    using difference_type = std::ptrdiff_t;
-    using value_type = const HashMap::value_type;
-    using pointer = value_type *;
-    using reference = value_type &;
-    using iterator_category = std::output_iterator_tag;
-
-    const_iterator () = default;
-    const_iterator (const ListNode *node, const HashMap *home) : node_(node), home_(home) {}
-    const_iterator (const iterator &other) : node_(other.node_), home_(other.home_) {}
-    auto operator++ (int) -> const_iterator {
-      if (node_ == &home_->pivot_) throw Exception("invalid state");
-      auto node = node_;
-      node_ = node_->next_;
-      return { node, home_ };
-    }
-    auto operator++ () -> const_iterator & {
-      if (node_ == &home_->pivot_) throw Exception("invalid state");
-      node_ = node_->next_;
-      return *this;
-    }
-    auto operator-- (int) -> const_iterator {
-      if (node_ == home_->pivot_.next_) throw Exception("invalid state");
-      auto node = node_;
-      node_ = node_->prev_;
-      return { node, home_ };
+    Iterator () = default;
+    Iterator (size_t ix, Home *home) : ix_(ix), home_(home) {}
+    Iterator (const Iterator<!kConst> &other) requires kConst
+      : ix_(other.ix_), home_(other.home_) {}
+    auto operator++ (int) -> Iterator {
+      auto copy = *this;
+      ++*this;
+      return copy;
     }
-    auto operator-- () -> const_iterator & {
-      if (node_ == home_->pivot_.next_) throw Exception("invalid state");
-      node_ = node_->prev_;
+    auto operator++ () -> Iterator & {
+      if (ix_ == kNil) throw Exception("invalid state");
+      ix_ = home_->next_(ix_);
       return *this;
     }
     auto operator* () const -> reference {
-      return node_->self->value;
-    }
-    auto operator== (const iterator &rhs) const -> bool {
-      return node_ == rhs.node_;
-    }
-    auto operator== (const const_iterator &rhs) const -> bool {
-      return node_ == rhs.node_;
-    }
-    auto operator!= (const iterator &rhs) const -> bool {
-      return !(*this == rhs);
-    }
-    auto operator!= (const const_iterator &rhs) const -> bool {
-      return !(*this == rhs);
+      return home_->slots_[ix_];
     }
     auto operator-> () const noexcept -> pointer {
       return &**this;
     }
+    template <bool kOther>
+    auto operator== (const Iterator<kOther> &rhs) const -> bool {
+      return ix_ == rhs.ix_;
+    }
+
    private:
-    const ListNode *node_;
-    const HashMap *home_;
-    friend class iterator;
+    size_t ix_ = kNil;
+    Home *home_ = nullptr;
+    friend class Iterator<!kConst>;
     friend class HashMap;
   };
 
+ public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
   HashMap () = default;
-  HashMap (const HashMap &other) { *this = other; }
+  HashMap (const HashMap &other) { copy_(other); }
+  HashMap (HashMap &&other) noexcept { swap_(other); }
   auto operator= (const HashMap &other) -> HashMap & {
     if (this == &other) return *this;
     clear();
-    capacity_ = other.capacity_;
-    size_ = other.size_;
-    store_ = new ListNode[internal::pow2[capacity_]];
-    const ListNode *node = &other.pivot_;
-    for (int i = 0; i < size_; ++i) {
-      node = node->next_;
-      Node *newNode = new Node(*(node->self));
-      int ix = newNode->hash & internal::mask[capacity_];
-      newNode->hashList.insertBefore(&store_[ix]);
-      newNode->iteratorList.insertBefore(&pivot_);
-    }
+    copy_(other);
+    return *this;
+  }
+  auto operator= (HashMap &&other) noexcept -> HashMap & {
+    if (this == &other) return *this;
+    clear();
+    swap_(other);
     return *this;
   }
   ~HashMap () {
-    destroy_();
+    clear();
   }
 
   /**
@@ -197,19 +209,28 @@ template <
    *   performing an insertion if such key does not already exist.
    */
   auto operator[] (const Key &key) -> Value & {
-    return insert({ key, Value() }).first->second;
+    auto hash = hash_(key);
+    auto ix = locate_(key, hash);
+    if (ix == kNil) {
+      ix = vacancy_(hash);
+      new (slots_ + ix) value_type(key, Value());
+      occupy_(ix, hash);
+    }
+    return slots_[ix].second;
   }
 
   /// behave like at() throw index_out_of_bound if such key does not exist.
   auto operator[] (const Key &key) const -> const Value & { return at(key); }
 
   /// return a iterator to the beginning
-  auto begin () -> iterator { return { pivot_.next_, this }; }
-  auto cbegin () const -> const_iterator { return { pivot_.next_, this }; }
+  auto begin () -> iterator { return { first_(), this }; }
+  auto begin () const -> const_iterator { return cbegin(); }
+  auto cbegin () const -> const_iterator { return { first_(), this }; }
 
   /// return a iterator to the end
-  auto end () -> iterator { return { &pivot_, this }; }
-  auto cend () const -> const_iterator { return { &pivot_, this }; }
+  auto end () -> iterator { return { kNil, this }; }
+  auto end () const -> const_iterator { return cend(); }
+  auto cend () const -> const_iterator { return { kNil, this }; }
 
   /// checks whether the container is empty
   auto empty () const -> bool {
@@ -220,9 +241,17 @@ template <
     return size_;
   }
 
-  /// clears the contents
+  /// clears the contents, and frees the table.
   auto clear () -> void {
-    destroy_();
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] != kEmpty) slots_[i].~value_type();
+    }
+    deallocate_(ctrl_, slots_, links_, capacity_);
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    links_ = nullptr;
+    capacity_ = size_ = 0;
+    head_ = tail_ = kNil;
   }
 
   /**
@@ -232,22 +261,13 @@ template <
    *   the second one is true if insert successfully, or false.
    */
   auto insert (const value_type &value) -> Pair<iterator, bool> {
-    auto &[ k, _ ] = value;
-    auto hash = hash_(k);
-    if (capacity_ > 0) {
-      int ix = hash & internal::mask[capacity_];
-      if (store_[ix].next() != nullptr) {
-        Node *node = store_[ix].next()->find(k);
-        if (node != nullptr) return { { &node->iteratorList, this }, false };
-      }
-    }
-    growIfNeeded_();
-    int ix = hash & internal::mask[capacity_];
-    Node *node = new Node(value, hash);
-    node->hashList.insertBefore(&store_[ix]);
-    node->iteratorList.insertBefore(&pivot_);
-    ++size_;
-    return { { &node->iteratorList, this }, true };
+    auto hash = hash_(value.first);
+    auto ix = locate_(value.first, hash);
+    if (ix != kNil) return { { ix, this }, false };
+    ix = vacancy_(hash);
+    new (slots_ + ix) value_type(value);
+    occupy_(ix, hash);
+    return { { ix, this }, true };
   }
 
   /**
@@ -255,12 +275,28 @@ template <
    * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
    */
   auto erase (iterator pos) -> void {
-    if (pos == end() || pos.home_ != this) throw Exception("invalid state");
-    pos.node_->self->hashList.remove();
-    pos.node_->self->iteratorList.remove();
-    delete pos.node_->self;
-    pos.node_ = &pivot_;
+    if (pos.home_ != this || pos.ix_ >= capacity_
+      || ctrl_[pos.ix_] == kEmpty) {
+      throw Exception("invalid state");
+    }
+    auto hole = pos.ix_;
+    if constexpr (kOrdered) unlink_(hole);
+    slots_[hole].~value_type();
     --size_;
+    // moves back every element after the hole which may be
+    // there, i.e. whose home slot is not in (hole, ix].
+    const auto mask = capacity_ - 1;
+    for (auto ix = (hole + 1) & mask; ctrl_[ix] != kEmpty;
+      ix = (ix + 1) & mask) {
+      auto home = slotOf_(hash_(slots_[ix].first));
+      if (((ix - home) & mask) < ((ix - hole) & mask)) continue;
+      new (slots_ + hole) value_type(std::move(slots_[ix]));
+      slots_[ix].~value_type();
+      setCtrl_(hole, ctrl_[ix]);
+      if constexpr (kOrdered) relink_(ix, hole);
+      hole = ix;
+    }
+    setCtrl_(hole, kEmpty);
   }
 
   /**
@@ -284,101 +320,237 @@ template <
    *   If no such element is found, past-the-end (see end()) iterator is returned.
    */
   auto find (const Key &key) -> iterator {
-    if (empty()) return end();
-    auto ix = hash_(key) & internal::mask[capacity_];
-    if (store_[ix].next() == nullptr) return end();
-    Node *node = store_[ix].next()->find(key);
-    if (node == nullptr) return end();
-    return { &node->iteratorList, this };
+    return { locate_(key, hash_(key)), this };
   }
   auto find (const Key &key) const -> const_iterator {
-    return const_cast<HashMap *>(this)->find(key);
+    return { locate_(key, hash_(key)), this };
+  }
+
+  /**
+   * Heterogeneous versions of find() and contains(), only
+   * available if Hash is transparent (see StringHash).
+   */
+  template <typename K>
+    requires requires { typename Hash::is_transparent; }
+  auto find (const K &key) -> iterator {
+    return { locate_(key, hash_(key)), this };
+  }
+  template <typename K>
+    requires requires { typename Hash::is_transparent; }
+  auto find (const K &key) const -> const_iterator {
+    return { locate_(key, hash_(key)), this };
+  }
+  template <typename K>
+    requires requires { typename Hash::is_transparent; }
+  auto contains (const K &key) const -> bool {
+    return find(key) != cend();
   }
 
  private:
-  struct ListNode {
-    ListNode *prev_ = this;
-    ListNode *next_ = this;
-    auto next () -> Node * { return next_->self; }
-    auto prev () -> Node * { return prev_->self; }
-    Node *self = nullptr;
-    ListNode () = default;
-    ListNode (Node *node) : self(node) {}
-
-    auto insertBefore (ListNode *pivot) -> void {
-      prev_ = pivot->prev_;
-      next_ = pivot;
-      pivot->prev_ = prev_->next_ = this;
-    }
-    auto remove () -> void {
-      prev_->next_ = next_;
-      next_->prev_ = prev_;
-    }
-    auto init () -> void {
-      prev_ = next_ = this;
-    }
+  using Group = internal::ControlGroup;
+  static constexpr size_t kWidth = Group::kWidth;
+  static constexpr int8_t kEmpty = Group::kEmpty;
+  /// the index of no slot, and of the end of iteration.
+  static constexpr size_t kNil = -1;
+  /// the neighbours of a slot in the insertion order.
+  struct Link {
+    size_t prev, next;
   };
 
-  struct Node {
-    value_type value;
-    unsigned hash;
-    ListNode iteratorList = this, hashList = this;
-    Node () = default;
-    Node (const Node &node) : value(node.value), hash(node.hash) {}
-    Node (const value_type &value, unsigned hash) : value(value), hash(hash) {}
-    auto find (const Key &key) -> Node * {
-      if (Equal()(key, value.first)) return this;
-      if (hashList.next() == nullptr) return nullptr;
-      return hashList.next()->find(key);
-    }
-  };
-  ListNode pivot_;
-  ListNode *store_ = nullptr;
-  int size_ = 0;
-  int capacity_ = 0;
-  constexpr static int kThreshold_ = 2;
+  /// capacity_ bytes, followed by copies of the first
+  /// kWidth - 1, so that a group may start at any slot.
+  int8_t *ctrl_ = nullptr;
+  value_type *slots_ = nullptr;
+  /// only if kOrdered.
+  Link *links_ = nullptr;
+  /// 0, or a power of 2 no less than kWidth.
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  /// the first and the last slots inserted, if kOrdered.
+  size_t head_ = kNil, tail_ = kNil;
   Hash hash0_;
-  auto hash_ (const Key &key) const -> unsigned {
+
+  template <typename K>
+  auto hash_ (const K &key) const -> unsigned long long {
     return internal::rehash(hash0_(key));
   }
-  auto growIfNeeded_ () -> void {
-    auto capacityNeeded = static_cast<unsigned long long>((size_ + 1) * kThreshold_);
-    if (capacityNeeded > internal::pow2[capacity_]) grow_();
+  auto slotOf_ (unsigned long long hash) const -> size_t {
+    return (hash >> 7) & (capacity_ - 1);
+  }
+  static auto h2_ (unsigned long long hash) -> int8_t {
+    return hash & 0x7f;
+  }
+  auto setCtrl_ (size_t ix, int8_t ctrl) -> void {
+    ctrl_[ix] = ctrl;
+    if (ix < kWidth - 1) ctrl_[capacity_ + ix] = ctrl;
+  }
+
+  /// finds the slot of key, or kNil.
+  template <typename K>
+  auto locate_ (const K &key, unsigned long long hash) const -> size_t {
+    if (size_ == 0) return kNil;
+    const auto mask = capacity_ - 1;
+    auto h2 = h2_(hash);
+    // the table is never full, so an empty slot ends the
+    // probe sequence.
+    for (auto pos = slotOf_(hash); ; pos = (pos + kWidth) & mask) {
+      Group group(ctrl_ + pos);
+      for (auto bits = group.match(h2); bits != 0; bits &= bits - 1) {
+        auto ix = (pos + std::countr_zero(bits)) & mask;
+        if (Equal()(key, slots_[ix].first)) return ix;
+      }
+      if (group.matchEmpty() != 0) return kNil;
+    }
   }
-  auto grow_ () -> void {
-    if (capacity_ == 0) {
-      capacity_ = 2;
-      store_ = new ListNode[4];
-      return;
+  /// finds the first empty slot in the probe sequence.
+  auto findEmpty_ (unsigned long long hash) const -> size_t {
+    const auto mask = capacity_ - 1;
+    for (auto pos = slotOf_(hash); ; pos = (pos + kWidth) & mask) {
+      auto bits = Group(ctrl_ + pos).matchEmpty();
+      if (bits != 0) return (pos + std::countr_zero(bits)) & mask;
     }
-    int newCapacity = capacity_ + 1;
-    auto prospective = new ListNode[internal::pow2[newCapacity]];
-    auto node = &pivot_;
-    for (int i = 0; i < size_; ++i) {
-      node = node->next_;
-      int ix = node->self->hash & internal::mask[newCapacity];
-      node->self->hashList.insertBefore(&prospective[ix]);
+  }
+  /// makes room for one more element, and gets the empty
+  /// slot where it goes. The caller constructs the element
+  /// and then occupy_()s the slot.
+  auto vacancy_ (unsigned long long hash) -> size_t {
+    if ((size_ + 1) * 4 > capacity_ * 3) {
+      rehash_(capacity_ == 0 ? kWidth : capacity_ * 2);
     }
-    capacity_ = newCapacity;
-    delete[] store_;
-    store_ = prospective;
+    return findEmpty_(hash);
+  }
+  auto occupy_ (size_t ix, unsigned long long hash) -> void {
+    setCtrl_(ix, h2_(hash));
+    if constexpr (kOrdered) {
+      links_[ix] = { tail_, kNil };
+      (tail_ == kNil ? head_ : links_[tail_].next) = ix;
+      tail_ = ix;
+    }
+    ++size_;
+  }
+  auto unlink_ (size_t ix) -> void {
+    auto [ prev, next ] = links_[ix];
+    (prev == kNil ? head_ : links_[prev].next) = next;
+    (next == kNil ? tail_ : links_[next].prev) = prev;
+  }
+  /// points the neighbours of the element moved from slot
+  /// from to its new slot to.
+  auto relink_ (size_t from, size_t to) -> void {
+    auto [ prev, next ] = links_[to] = links_[from];
+    (prev == kNil ? head_ : links_[prev].next) = to;
+    (next == kNil ? tail_ : links_[next].prev) = to;
   }
 
-  auto destroy_ () -> void {
-    ListNode *node = pivot_.next_;
-    for (int i = 0; i < size_; ++i) {
-      ListNode *next = node->next_;
-      delete node->self;
-      node = next;
+  auto first_ () const -> size_t {
+    if constexpr (kOrdered) return head_;
+    return scan_(0);
+  }
+  auto next_ (size_t ix) const -> size_t {
+    if constexpr (kOrdered) return links_[ix].next;
+    return scan_(ix + 1);
+  }
+  /// finds the first element at or after slot ix.
+  auto scan_ (size_t ix) const -> size_t {
+    for (; ix < capacity_; ++ix) {
+      if (ctrl_[ix] != kEmpty) return ix;
     }
-    capacity_ = 0;
+    return kNil;
+  }
+
+  auto allocate_ (size_t capacity) -> void {
+    ctrl_ = (int8_t *) Alloc::allocate(capacity + kWidth - 1, 1);
+    memset(ctrl_, kEmpty, capacity + kWidth - 1);
+    slots_ = (value_type *) Alloc::allocate(
+      capacity * sizeof(value_type), alignof(value_type));
+    if constexpr (kOrdered) {
+      links_ = (Link *) Alloc::allocate(
+        capacity * sizeof(Link), alignof(Link));
+    }
+    capacity_ = capacity;
+  }
+  static auto deallocate_ (
+    int8_t *ctrl, value_type *slots, Link *links, size_t capacity
+  ) -> void {
+    if (capacity == 0) return;
+    Alloc::deallocate(ctrl, capacity + kWidth - 1);
+    Alloc::deallocate(slots, capacity * sizeof(value_type));
+    if constexpr (kOrdered) {
+      Alloc::deallocate(links, capacity * sizeof(Link));
+    }
+  }
+  /// moves the elements into a new table, keeping their
+  /// insertion order.
+  auto rehash_ (size_t capacity) -> void {
+    auto ctrl = ctrl_;
+    auto slots = slots_;
+    auto links = links_;
+    auto oldCapacity = capacity_;
+    auto head = head_;
+    allocate_(capacity);
     size_ = 0;
-    delete[] store_;
-    store_ = nullptr;
-    pivot_.init();
+    head_ = tail_ = kNil;
+    auto move = [&] (size_t from) {
+      auto hash = hash_(slots[from].first);
+      auto ix = findEmpty_(hash);
+      new (slots_ + ix) value_type(std::move(slots[from]));
+      slots[from].~value_type();
+      occupy_(ix, hash);
+    };
+    if constexpr (kOrdered) {
+      for (auto i = head; i != kNil; i = links[i].next) move(i);
+    } else {
+      for (size_t i = 0; i < oldCapacity; ++i) {
+        if (ctrl[i] != kEmpty) move(i);
+      }
+    }
+    deallocate_(ctrl, slots, links, oldCapacity);
+  }
+  /// copies the table of other, slot by slot, into this
+  /// empty map.
+  auto copy_ (const HashMap &other) -> void {
+    if (other.capacity_ == 0) return;
+    allocate_(other.capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (other.ctrl_[i] != kEmpty) {
+        new (slots_ + i) value_type(other.slots_[i]);
+      }
+      setCtrl_(i, other.ctrl_[i]);
+    }
+    if constexpr (kOrdered) {
+      memcpy(links_, other.links_, capacity_ * sizeof(Link));
+    }
+    size_ = other.size_;
+    head_ = other.head_;
+    tail_ = other.tail_;
+  }
+  auto swap_ (HashMap &other) -> void {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(links_, other.links_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
   }
 };
 
+/// A HashMap iterated in the insertion order.
+template <
+  typename Key,
+  typename Value,
+  typename Hash = std::hash<Key>,
+  typename Equal = std::equal_to<Key>
+> using LinkedHashMap = HashMap<Key, Value, Hash, Equal, true>;
+
+/// A HashMap of the temporaries of a command (see Arena).
+template <
+  typename Key,
+  typename Value,
+  typename Hash = std::hash<Key>,
+  typename Equal = std::equal_to<Key>
+> using ArenaHashMap =
+  HashMap<Key, Value, Hash, Equal, false, ArenaAllocator>;
+
 } // namespace ticket
 
 #endif // TICKET_LIB_HASHMAP_H_
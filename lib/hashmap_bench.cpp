@@ -0,0 +1,137 @@
+// Microbenchmarks of HashMap against std::unordered_map, on
+// the shapes of keys the server uses: dense integers (ids),
+// hashes of names (station and stop keys), and strings
+// (usernames). Built only with -DBENCH=1, and not run by
+// ctest.
+#include "hashmap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// a deterministic sequence, the same for both maps.
+auto keys (size_t n, unsigned long long seed) -> std::vector<size_t> {
+  std::vector<size_t> result(n);
+  for (auto &key : result) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    key = seed >> 20;
+  }
+  return result;
+}
+
+/// the keys in another order than inserted, as the nodes of
+/// a chaining map lie in memory in the insertion order.
+template <typename T>
+auto shuffled (const std::vector<T> &from) -> std::vector<T> {
+  std::vector<T> result;
+  result.reserve(from.size());
+  for (size_t i = 0; i < from.size(); ++i) {
+    result.push_back(from[i * 7919 % from.size()]);
+  }
+  return result;
+}
+
+template <typename Fn>
+auto time (const char *name, const char *map, size_t ops, const Fn &fn)
+  -> void {
+  auto start = std::chrono::steady_clock::now();
+  auto checksum = fn();
+  std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  printf("%-24s %-14s %8.2f ns/op  (%zu)\n",
+    name, map, elapsed.count() / ops, (size_t) checksum);
+}
+
+template <typename Map>
+auto run (const char *map, size_t n) -> void {
+  auto present = keys(n, 1), absent = keys(n, 2);
+  auto lookups = shuffled(present);
+  std::vector<size_t> dense(n);
+  for (size_t i = 0; i < n; ++i) dense[i] = i;
+  std::vector<std::string> names(n);
+  for (size_t i = 0; i < n; ++i) names[i] = "user" + std::to_string(present[i]);
+  auto denseLookups = shuffled(dense);
+  auto nameLookups = shuffled(names);
+
+  Map ints;
+  time("insert random", map, n, [&] {
+    for (auto key : present) ints[key] = (int) key;
+    return ints.size();
+  });
+  time("find hit", map, n, [&] {
+    size_t sum = 0;
+    for (auto key : lookups) sum += ints.find(key)->second;
+    return sum;
+  });
+  time("find miss", map, n, [&] {
+    size_t found = 0;
+    for (auto key : absent) found += ints.find(key) != ints.end();
+    return found;
+  });
+  time("erase half", map, n / 2, [&] {
+    for (size_t i = 0; i < n; i += 2) ints.erase(ints.find(present[i]));
+    return ints.size();
+  });
+  time("find after erase", map, n, [&] {
+    size_t found = 0;
+    for (auto key : lookups) found += ints.find(key) != ints.end();
+    return found;
+  });
+  time("iterate", map, ints.size(), [&] {
+    size_t sum = 0;
+    for (const auto &pair : ints) sum += pair.second;
+    return sum;
+  });
+
+  Map ids;
+  time("insert dense", map, n, [&] {
+    for (auto key : dense) ids[key] = (int) key;
+    return ids.size();
+  });
+  time("find dense", map, n, [&] {
+    size_t sum = 0;
+    for (auto key : denseLookups) sum += ids.find(key)->second;
+    return sum;
+  });
+
+  // many small maps, as built and dropped by each command.
+  time("small maps (16)", map, n, [&] {
+    size_t sum = 0;
+    for (size_t i = 0; i + 16 <= n; i += 16) {
+      Map small;
+      for (size_t j = i; j < i + 16; ++j) small[present[j] & 63] += 1;
+      sum += small.size();
+    }
+    return sum;
+  });
+
+  using StringMap = std::conditional_t<
+    std::is_same_v<Map, std::unordered_map<size_t, int>>,
+    std::unordered_map<std::string, int>,
+    ticket::HashMap<std::string, int>>;
+  StringMap strings;
+  time("insert string", map, n, [&] {
+    for (const auto &name : names) strings[name] = 1;
+    return strings.size();
+  });
+  time("find string", map, n, [&] {
+    size_t sum = 0;
+    for (const auto &name : nameLookups) {
+      sum += strings.find(name)->second;
+    }
+    return sum;
+  });
+}
+
+} // namespace
+
+auto main (int argc, char *argv[]) -> int {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+  run<ticket::HashMap<size_t, int>>("HashMap", n);
+  run<std::unordered_map<size_t, int>>("unordered_map", n);
+  return 0;
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <vector>
 class Integer {
 public:
 	static int counter;
@@ -66,10 +67,65 @@ void tester(void) {
 	}
 }
 
+// erases at random against a reference, so that the
+// backward shifts run over long probe sequences.
+void checkErase(void) {
+	ticket::HashMap<int,int> map;
+	std::vector<int> ref(4096, -1);
+	for(int i=0;i<200000;++i) {
+		int k=getNum()%4096;
+		auto it=map.find(k);
+		assert((it==map.end())==(ref[k]<0));
+		if(it==map.end()) {
+			map.insert({k,i});
+			ref[k]=i;
+		} else {
+			assert(it->second==ref[k]);
+			map.erase(it);
+			ref[k]=-1;
+		}
+	}
+	size_t n=0;
+	for(int k=0;k<4096;++k) {
+		if(ref[k]>=0) {
+			++n;
+			assert(map.at(k)==ref[k]);
+		}
+	}
+	assert(map.size()==n);
+	ticket::HashMap<int,int> copy(map);
+	for(auto &pair : map) assert(copy.at(pair.first)==pair.second);
+}
+
+// the linked map iterates in the insertion order, across
+// erasures and rehashes.
+void checkOrder(void) {
+	ticket::LinkedHashMap<std::string,int,ticket::StringHash,std::equal_to<>> map;
+	std::vector<int> order;
+	for(int i=0;i<1000;++i) {
+		map.insert({std::to_string(i),i});
+		order.push_back(i);
+		if(i%3==0) {
+			int k=order[order.size()/2];
+			map.erase(map.find(std::string_view(std::to_string(k))));
+			order.erase(order.begin()+order.size()/2);
+		}
+	}
+	assert(!map.insert({std::to_string(order.back()),-1}).second);
+	auto copy=map;
+	size_t i=0;
+	for(auto it=copy.cbegin();it!=copy.cend();++it,++i) {
+		assert(it->second==order[i]);
+	}
+	assert(i==order.size() && i==map.size());
+}
+
 int main(void) {
 	std::ios::sync_with_stdio(false);
 	std::cin.tie(0);
 	std::cout.tie(0);
 	tester();
+	checkErase();
+	checkOrder();
 	std::cout << Integer::counter << std::endl;
 }
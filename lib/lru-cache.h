@@ -23,9 +23,15 @@ class LruCache {
   }
   /// tries to obtain the value at the designated key.
   auto get (const Key &key) -> Optional<void *> {
+    int length;
+    return get(key, length);
+  }
+  /// same as above, also storing the length of the value.
+  auto get (const Key &key, int &length) -> Optional<void *> {
     auto it = storage_.find(key);
     if (it == storage_.end()) return unit;
     auto buf = it->second.value;
+    length = it->second.length;
     touch_(it);
     return buf;
   }
@@ -116,7 +122,7 @@ class LruCache {
     int length;
     bool dirty;
   };
-  HashMap<Key, Payload> storage_;
+  LinkedHashMap<Key, Payload> storage_;
   BeforeDestroy callback_;
 
   template <typename Iterator>
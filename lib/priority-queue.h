@@ -1,10 +1,16 @@
 #ifndef TICKET_LIB_PRIORITY_QUEUE_H_
 #define TICKET_LIB_PRIORITY_QUEUE_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
+#include <new>
+#include <utility>
 
+#include "allocator.h"
 #include "exception.h"
+#include "utility.h"
+#include "vector.h"
 
 #ifdef DEBUG
 #include <iostream>
@@ -15,74 +21,254 @@
 
 namespace panic {
 
-template <typename T, class Compare = std::less<T>>
-class PairingHeap {
+/**
+ * @brief A pairing heap, the default backing structure of
+ * PriorityQueue.
+ *
+ * Pushing and merging take O(1), and popping O(log n)
+ * amortized. The nodes popped are kept in a pool and reused
+ * by the next pushes, so a heap which is pushed and popped
+ * in turns only allocates up to its largest size. Every
+ * traversal is iterative, as the list of children of the
+ * root grows as long as the heap under a run of pushes.
+ */
+template <
+  typename T,
+  class Compare = std::less<T>,
+  typename Alloc = ticket::HeapAllocator
+> class PairingHeap {
  public:
+  PairingHeap () = default;
+  PairingHeap (const Compare &cmp) : less_(cmp) {}
+  PairingHeap (const PairingHeap &other) : less_(other.less_) {
+    copy_(other);
+  }
+  auto operator= (const PairingHeap &other) -> PairingHeap & {
+    if (this == &other) return *this;
+    clear();
+    less_ = other.less_;
+    copy_(other);
+    return *this;
+  }
+  ~PairingHeap () {
+    clear();
+    while (pool_ != nullptr) {
+      auto next = pool_->next;
+      Alloc::deallocate(pool_, sizeof(Node));
+      pool_ = next;
+    }
+  }
+
+  auto top () const -> const T & { return root_->value; }
+  auto push (const T &value) -> void {
+    root_ = mergeRoots_(root_, create_(value));
+    ++size_;
+  }
+  auto pop () -> void {
+    if (root_ == nullptr) throw ticket::OutOfBounds();
+    auto firstChild = root_->firstChild;
+    recycle_(root_);
+    root_ = mergeChildren_(firstChild);
+    --size_;
+  }
+  auto size () const -> size_t { return size_; }
+  /// moves all the elements of other into this heap.
+  auto merge (PairingHeap &other) -> void {
+    root_ = mergeRoots_(root_, other.root_);
+    size_ += other.size_;
+    other.root_ = nullptr;
+    other.size_ = 0;
+  }
+  auto clear () -> void {
+    // the nodes still to free, linked by neighbor.
+    auto todo = root_;
+    while (todo != nullptr) {
+      auto node = todo;
+      todo = node->neighbor;
+      if (node->firstChild != nullptr) {
+        auto last = node->firstChild;
+        while (last->neighbor != nullptr) last = last->neighbor;
+        last->neighbor = todo;
+        todo = node->firstChild;
+      }
+      recycle_(node);
+    }
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+ private:
   struct Node {
     T value;
     Node *firstChild = nullptr;
     Node *neighbor = nullptr;
 
     Node (const T &value) : value(value) {}
-    Node (const Node &other) : value(other.value) {
-      // _log("PairingHeap::Node::Node(const Node&)");
-      if (other.firstChild != nullptr) firstChild = new Node(*other.firstChild);
-      if (other.neighbor != nullptr) neighbor = new Node(*other.neighbor);
-    }
-    auto destroy () -> void {
-      if (firstChild != nullptr) {
-        firstChild->destroy();
-        delete firstChild;
-      }
-      if (neighbor != nullptr) {
-        neighbor->destroy();
-        delete neighbor;
-      }
-    }
+  };
+  /// a node in the pool.
+  struct Free {
+    Free *next;
   };
 
-  Compare less;
-  Node *root = nullptr;
+  Compare less_;
+  Node *root_ = nullptr;
+  size_t size_ = 0;
+  Free *pool_ = nullptr;
+
+  auto create_ (const T &value) -> Node * {
+    void *memory;
+    if (pool_ != nullptr) {
+      memory = pool_;
+      pool_ = pool_->next;
+    } else {
+      memory = Alloc::allocate(sizeof(Node), alignof(Node));
+    }
+    return new (memory) Node(value);
+  }
+  /// destroys a node, but not its children, and pools it.
+  auto recycle_ (Node *node) -> void {
+    node->~Node();
+    pool_ = new (node) Free { pool_ };
+  }
 
   /// merges two trees and returns the new root.
-  auto mergeRoots (Node *a, Node *b) -> Node * {
+  auto mergeRoots_ (Node *a, Node *b) -> Node * {
     if (a == nullptr) return b;
     if (b == nullptr) return a;
-    if (less(a->value, b->value)) std::swap(a, b);
+    if (less_(a->value, b->value)) std::swap(a, b);
     // a >= b here
     // since b is a tree root, it could not have a neighbor
     b->neighbor = a->firstChild;
     a->firstChild = b;
     return a;
   }
+  /**
+   * merges the children of the old root, and returns the
+   * new root.
+   *
+   * the children are merged in pairs from left to right,
+   * and then the pairs from right to left.
+   */
+  auto mergeChildren_ (Node *firstChild) -> Node * {
+    // the merged pairs, the last first, linked by neighbor.
+    Node *pairs = nullptr;
+    while (firstChild != nullptr) {
+      auto a = firstChild, b = a->neighbor;
+      if (b == nullptr) {
+        a->neighbor = pairs;
+        pairs = a;
+        break;
+      }
+      firstChild = b->neighbor;
+      a->neighbor = b->neighbor = nullptr;
+      auto pair = mergeRoots_(a, b);
+      pair->neighbor = pairs;
+      pairs = pair;
+    }
+    Node *root = nullptr;
+    while (pairs != nullptr) {
+      auto next = pairs->neighbor;
+      pairs->neighbor = nullptr;
+      root = mergeRoots_(root, pairs);
+      pairs = next;
+    }
+    return root;
+  }
+  /// copies the trees of other into this empty heap.
+  auto copy_ (const PairingHeap &other) -> void {
+    // the nodes to copy, and where to link their copies.
+    ticket::Vector<std::pair<const Node *, Node **>> todo;
+    if (other.root_ != nullptr) todo.push_back({ other.root_, &root_ });
+    while (!todo.empty()) {
+      auto [ from, to ] = todo.back();
+      todo.pop_back();
+      auto node = *to = create_(from->value);
+      if (from->firstChild != nullptr) {
+        todo.push_back({ from->firstChild, &node->firstChild });
+      }
+      if (from->neighbor != nullptr) {
+        todo.push_back({ from->neighbor, &node->neighbor });
+      }
+    }
+    size_ = other.size_;
+  }
+};
 
-  /// merges all the children of the root node and returns the new root.
-  auto mergeChildren (Node *firstChild) -> Node * {
-    if (firstChild == nullptr) return nullptr;
-    Node *secondChild = firstChild->neighbor;
-    if (secondChild == nullptr) return firstChild;
-    Node *thirdChild = secondChild->neighbor;
-    firstChild->neighbor = secondChild->neighbor = nullptr;
-    return mergeRoots(mergeRoots(firstChild, secondChild), mergeChildren(thirdChild));
+/**
+ * @brief An implicit d-ary heap in an array, another
+ * backing structure of PriorityQueue.
+ *
+ * The elements lie in one Vector, the children of the i-th
+ * at kArity * i + 1 and after, so a push allocates nothing
+ * but the growth of the array, and the children compared by
+ * a pop share a cache line or two. Merging pushes the
+ * elements one by one.
+ */
+template <
+  typename T,
+  class Compare = std::less<T>,
+  typename Alloc = ticket::HeapAllocator,
+  int kArity = 4
+> class DaryHeap {
+  static_assert(kArity >= 2);
+ public:
+  DaryHeap () = default;
+  DaryHeap (const Compare &cmp) : less_(cmp) {}
+
+  auto top () const -> const T & { return items_.front(); }
+  auto push (const T &value) -> void {
+    items_.push_back(value);
+    siftUp_(items_.size() - 1);
+  }
+  auto pop () -> void {
+    if (items_.empty()) throw ticket::OutOfBounds();
+    auto last = std::move(*(items_.end() - 1));
+    items_.pop_back();
+    if (!items_.empty()) siftDown_(std::move(last));
+  }
+  auto size () const -> size_t { return items_.size(); }
+  /// moves all the elements of other into this heap.
+  auto merge (DaryHeap &other) -> void {
+    for (const auto &item : other.items_) push(item);
+    other.items_.clear();
   }
+  auto clear () -> void { items_.clear(); }
 
-  PairingHeap () = default;
-  PairingHeap (const Compare &cmp) : less(cmp) {}
-  PairingHeap (const PairingHeap &other) { *this = other; }
-  ~PairingHeap () {
-    if (root != nullptr) root->destroy();
-    delete root;
+ private:
+  Compare less_;
+  ticket::Vector<T, Alloc> items_;
+
+  auto data_ () -> T * { return &*items_.begin(); }
+  /// moves the i-th element up to its place.
+  auto siftUp_ (size_t i) -> void {
+    auto data = data_();
+    auto value = std::move(data[i]);
+    while (i > 0) {
+      auto parent = (i - 1) / kArity;
+      if (!less_(data[parent], value)) break;
+      data[i] = std::move(data[parent]);
+      i = parent;
+    }
+    data[i] = std::move(value);
   }
-  auto operator= (const PairingHeap &other) -> PairingHeap & {
-    if (this == &other) return *this;
-    if (root != nullptr) {
-      root->destroy();
-      delete root;
-      root = nullptr;
+  /// puts value at the root, and moves it down to its place.
+  auto siftDown_ (T &&value) -> void {
+    auto data = data_();
+    const size_t n = items_.size();
+    size_t i = 0;
+    while (true) {
+      auto first = i * kArity + 1;
+      if (first >= n) break;
+      auto last = std::min(first + kArity, n);
+      auto best = first;
+      for (auto child = first + 1; child < last; ++child) {
+        if (less_(data[best], data[child])) best = child;
+      }
+      if (!less_(value, data[best])) break;
+      data[i] = std::move(data[best]);
+      i = best;
     }
-    if (other.root != nullptr) root = new Node(*other.root);
-    less = other.less;
-    return *this;
+    data[i] = std::move(value);
   }
 };
 
@@ -90,8 +276,20 @@ class PairingHeap {
 
 namespace ticket {
 
-template <typename T, class Compare = std::less<T>>
-class PriorityQueue {
+/**
+ * @brief A priority queue, the greatest element on top.
+ *
+ * Heap is the backing structure: panic::PairingHeap for
+ * cheap merges, or panic::DaryHeap for the least memory
+ * traffic per element. Their nodes and arrays come from
+ * Alloc (see allocator.h).
+ */
+template <
+  typename T,
+  class Compare = std::less<T>,
+  typename Alloc = HeapAllocator,
+  template <typename, class, typename> class Heap = panic::PairingHeap
+> class PriorityQueue {
  public:
   PriorityQueue () = default;
   PriorityQueue (const Compare &cmp) : heap_(cmp) {}
@@ -100,50 +298,39 @@ class PriorityQueue {
    * @return a reference of the top element.
    * throw container_is_empty if empty() returns true;
    */
-  auto top () const -> const T & {
-    return heap_.root->value;
-  }
+  auto top () const -> const T & { return heap_.top(); }
   /// push new element to the priority queue.
-  auto push (const T &value) -> void {
-    Node *newNode = new Node(value);
-    heap_.root = heap_.mergeRoots(heap_.root, newNode);
-    ++size_;
-  }
+  auto push (const T &value) -> void { heap_.push(value); }
   /**
    * delete the top element.
    * throw container_is_empty if empty() returns true;
    */
-  auto pop () -> void {
-    Node *firstChild = heap_.root->firstChild;
-    delete heap_.root;
-    heap_.root = heap_.mergeChildren(firstChild);
-    --size_;
-  }
+  auto pop () -> void { heap_.pop(); }
   /// return the number of the elements.
-  auto size () const -> size_t { return size_; }
+  auto size () const -> size_t { return heap_.size(); }
   /**
    * check if the container has at least an element.
    * @return true if it is empty, false if it has at least an element.
    */
-  auto empty () const -> bool { return size_ == 0; }
+  auto empty () const -> bool { return heap_.size() == 0; }
   /**
    * merge two priority_queues with at ~~least~~ most O(logn) complexity.
    * clear the other priority_queue.
    */
-  auto merge (PriorityQueue &other) -> void {
-    size_ += other.size_;
-    other.size_ = 0;
-    heap_.root = heap_.mergeRoots(heap_.root, other.heap_.root);
-    other.heap_.root = nullptr;
-  }
+  auto merge (PriorityQueue &other) -> void { heap_.merge(other.heap_); }
 
  private:
-  using Heap = panic::PairingHeap<T, Compare>;
-  using Node = typename Heap::Node;
-  Heap heap_;
-  size_t size_ = 0;
+  Heap<T, Compare, Alloc> heap_;
 };
 
+/// A PriorityQueue of the temporaries of a command (see
+/// Arena).
+template <
+  typename T,
+  class Compare = std::less<T>,
+  template <typename, class, typename> class Heap = panic::PairingHeap
+> using ArenaPriorityQueue = PriorityQueue<T, Compare, ArenaAllocator, Heap>;
+
 } // namespace ticket
 
 #endif // TICKET_LIB_PRIORITY_QUEUE_H_
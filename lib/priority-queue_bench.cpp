@@ -0,0 +1,114 @@
+// Microbenchmarks of the backing structures of PriorityQueue,
+// on the pattern of query_transfer: a queue per station is
+// filled with the sections leaving it, and then every
+// arriving section pushes the sections moved to the next
+// day and pops the stale entries off the top. Built only
+// with -DBENCH=1, and not run by ctest.
+#include "priority-queue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+#include "allocator.h"
+
+namespace {
+
+/// the entry query_transfer pushes now.
+struct Small {
+  int arrival;
+  long long price;
+  void *section;
+  auto operator< (const Small &rhs) const -> bool {
+    return arrival > rhs.arrival;
+  }
+};
+/// the size of the std::pair<Section, Section *> it pushed
+/// before.
+struct Large {
+  int arrival;
+  char rest[84];
+  void *section;
+  auto operator< (const Large &rhs) const -> bool {
+    return arrival > rhs.arrival;
+  }
+};
+
+unsigned long long seed = 1;
+auto next () -> int {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed >> 40;
+}
+
+/// runs the pattern on `stations` queues of `size` sections.
+template <typename Queue>
+auto transfer (int stations, int size) -> long long {
+  using T = std::remove_cvref_t<decltype(std::declval<Queue>().top())>;
+  long long checksum = 0;
+  for (int s = 0; s < stations; ++s) {
+    ticket::Arena::Scope arena;
+    Queue queue;
+    T entry {};
+    for (int i = 0; i < size; ++i) {
+      entry.arrival = next() % 1440;
+      queue.push(entry);
+    }
+    for (int from = 0; from < size; ++from) {
+      // a few sections move to the next day.
+      for (int i = 0; i < 4; ++i) {
+        entry.arrival = 1440 + next() % 1440;
+        queue.push(entry);
+      }
+      // and a few stale entries are popped.
+      for (int i = 0; i < 3 && !queue.empty(); ++i) {
+        checksum += queue.top().arrival;
+        queue.pop();
+      }
+    }
+  }
+  return checksum;
+}
+
+template <typename Queue>
+auto time (const char *name, int stations, int size) -> void {
+  seed = 1;
+  auto start = std::chrono::steady_clock::now();
+  auto checksum = transfer<Queue>(stations, size);
+  std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  // size pushes, then 4 pushes and 3 pops per section.
+  long long ops = (long long) stations * size * 8;
+  printf("%-22s %6d %8.2f ns/op  (%lld)\n",
+    name, size, elapsed.count() / ops, checksum);
+}
+
+template <typename T, class C, typename A>
+using Binary = panic::DaryHeap<T, C, A, 2>;
+template <typename T, class C, typename A>
+using Octonary = panic::DaryHeap<T, C, A, 8>;
+
+template <typename T>
+auto run (const char *type, int size) -> void {
+  int stations = (1 << 21) / size;
+  printf("-- %s\n", type);
+  time<ticket::PriorityQueue<T>>("pairing, heap", stations, size);
+  time<ticket::ArenaPriorityQueue<T>>("pairing, arena", stations, size);
+  time<ticket::ArenaPriorityQueue<T, std::less<T>, Binary>>(
+    "2-ary, arena", stations, size);
+  time<ticket::ArenaPriorityQueue<T, std::less<T>, panic::DaryHeap>>(
+    "4-ary, arena", stations, size);
+  time<ticket::ArenaPriorityQueue<T, std::less<T>, Octonary>>(
+    "8-ary, arena", stations, size);
+}
+
+} // namespace
+
+auto main () -> int {
+  // query_transfer sees 1 to 4 sections per station on the
+  // test workloads; the larger sizes are for busier stations.
+  for (int size : { 4, 16, 256, 4096 }) {
+    run<Small>("24-byte entries", size);
+    run<Large>("104-byte entries", size);
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "priority-queue.h"
+
+#include <assert.h>
+
+#include <functional>
+#include <string>
+
+using ticket::PriorityQueue;
+
+template <typename T, class C, typename A>
+using Binary = panic::DaryHeap<T, C, A, 2>;
+
+/// pushes and pops in turns against a sorted reference.
+template <typename Queue>
+auto check () -> void {
+  Queue queue;
+  int counts[1000] = {};
+  unsigned seed = 1;
+  int size = 0;
+  for (int i = 0; i < 100000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    if (size == 0 || seed % 3 != 0) {
+      int x = (seed >> 8) % 1000;
+      queue.push(std::to_string(1000 + x));
+      ++counts[x];
+      ++size;
+    } else {
+      int top = 999;
+      while (counts[top] == 0) --top;
+      assert(queue.top() == std::to_string(1000 + top));
+      queue.pop();
+      --counts[top];
+      --size;
+    }
+    assert(queue.size() == size);
+  }
+
+  // copies are deep, and merging empties the other queue.
+  Queue copy(queue), other;
+  for (int i = 0; i < 100; ++i) other.push(std::to_string(3000 + i));
+  copy.merge(other);
+  assert(other.empty() && copy.size() == size + 100);
+  assert(copy.top() == "3099");
+  assert(queue.size() == size);
+
+  // a long run of pushes in order, the worst case of the
+  // pairing heap.
+  Queue run;
+  for (int i = 0; i < 1000000; ++i) run.push(std::to_string(i % 10));
+  Queue runCopy(run);
+  for (int i = 0; i < 99999; ++i) runCopy.pop();
+  assert(runCopy.top() == "9");
+  while (!run.empty()) run.pop();
+  bool thrown = false;
+  try {
+    run.pop();
+  } catch (const ticket::OutOfBounds &) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+auto main () -> int {
+  using Less = std::less<std::string>;
+  using Alloc = ticket::HeapAllocator;
+  check<PriorityQueue<std::string>>();
+  check<PriorityQueue<std::string, Less, Alloc, panic::DaryHeap>>();
+  check<PriorityQueue<std::string, Less, Alloc, Binary>>();
+  return 0;
+}
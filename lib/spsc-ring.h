@@ -0,0 +1,97 @@
+#ifndef TICKET_LIB_SPSC_RING_H_
+#define TICKET_LIB_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+
+namespace ticket {
+
+/**
+ * @brief A bounded queue between one producer thread and
+ * one consumer thread.
+ *
+ * The slots are reused in place rather than copied in and
+ * out: the producer fills acquire() and then publish()es
+ * it, and the consumer reads front() and then release()s
+ * it. So a slot may hold data pointing into itself, and
+ * keeps its buffers from one round to the next.
+ *
+ * Either side spins for a while when the ring is full or
+ * empty, and then sleeps until the other side moves.
+ */
+template <typename T, size_t kCapacity>
+class SpscRing {
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+    "the capacity must be a power of 2");
+ public:
+  SpscRing () : slots_(new T[kCapacity]) {}
+  SpscRing (const SpscRing &) = delete;
+  auto operator= (const SpscRing &) -> SpscRing & = delete;
+  ~SpscRing () { delete[] slots_; }
+
+  /// waits for a free slot, and gets it. producer only.
+  auto acquire () -> T & {
+    auto head = head_.load(std::memory_order_relaxed);
+    wait_(tail_, [head] (size_t tail) {
+      return head - tail < kCapacity;
+    });
+    return slots_[head & (kCapacity - 1)];
+  }
+  /// hands the acquired slot to the consumer. producer only.
+  auto publish () -> void {
+    head_.fetch_add(1, std::memory_order_release);
+    head_.notify_one();
+  }
+  /// waits for a published slot, and gets it. consumer only.
+  auto front () -> T & {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    wait_(head_, [tail] (size_t head) { return head != tail; });
+    return slots_[tail & (kCapacity - 1)];
+  }
+  /// gives the front slot back to the producer. consumer only.
+  auto release () -> void { release(1); }
+
+  /// gets the number of published slots, without waiting.
+  /// consumer only.
+  auto ready () const -> size_t {
+    return head_.load(std::memory_order_acquire)
+      - tail_.load(std::memory_order_relaxed);
+  }
+  /// gets the i-th published slot, i < ready(). consumer only.
+  auto at (size_t i) -> T & {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    return slots_[(tail + i) & (kCapacity - 1)];
+  }
+  /// gives the first n slots back. consumer only.
+  auto release (size_t n) -> void {
+    tail_.fetch_add(n, std::memory_order_release);
+    tail_.notify_one();
+  }
+
+ private:
+  static constexpr int kSpins = 1 << 10;
+  T *slots_;
+  /// the number of slots ever published.
+  alignas(64) std::atomic<size_t> head_ = 0;
+  /// the number of slots ever released.
+  alignas(64) std::atomic<size_t> tail_ = 0;
+
+  /// waits until ready(counter) holds, counter being moved
+  /// by the other side.
+  template <typename Pred>
+  static auto wait_ (std::atomic<size_t> &counter, const Pred &ready)
+    -> void {
+    for (int i = 0; i < kSpins; ++i) {
+      if (ready(counter.load(std::memory_order_acquire))) return;
+    }
+    while (true) {
+      auto value = counter.load(std::memory_order_acquire);
+      if (ready(value)) return;
+      counter.wait(value, std::memory_order_acquire);
+    }
+  }
+};
+
+} // namespace ticket
+
+#endif // TICKET_LIB_SPSC_RING_H_
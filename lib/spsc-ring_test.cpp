@@ -0,0 +1,39 @@
+#include "spsc-ring.h"
+
+#include <assert.h>
+
+#include <string>
+#include <thread>
+
+using ticket::SpscRing;
+
+struct Slot {
+  int value;
+  std::string text;
+};
+
+auto main () -> int {
+  constexpr int kCount = 200000;
+  SpscRing<Slot, 64> ring;
+  std::thread producer([&ring] {
+    for (int i = 0; i < kCount; ++i) {
+      auto &slot = ring.acquire();
+      slot.value = i;
+      slot.text = std::to_string(i);
+      ring.publish();
+    }
+  });
+  for (int i = 0; i < kCount;) {
+    auto &slot = ring.front();
+    assert(slot.value == i);
+    assert(slot.text == std::to_string(i));
+    // takes the slots published by now at once.
+    auto n = ring.ready();
+    assert(n >= 1 && n <= 64);
+    for (size_t j = 0; j < n; ++j) assert(ring.at(j).value == i + (int) j);
+    ring.release(n);
+    i += n;
+  }
+  producer.join();
+  return 0;
+}
@@ -22,6 +22,19 @@ auto split (std::string &str, char sep)
   return res;
 }
 
+auto splitView (std::string_view str, char sep)
+  -> Vector<std::string_view> {
+  Vector<std::string_view> res;
+  size_t start = 0;
+  for (size_t i = 0; i <= str.length(); ++i) {
+    if (i == str.length() || str[i] == sep) {
+      if (i != start) res.push_back(str.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+  return res;
+}
+
 auto copyStrings (const Vector<std::string_view> &vec)
   -> Vector<std::string> {
   return vec.map([] (const auto &x) {
@@ -12,6 +12,7 @@
 #endif // TICKET_DEBUG
 
 #include <iostream>
+#include <string_view>
 
 #include "vector.h"
 
@@ -31,6 +32,16 @@ namespace ticket {
 auto split (std::string &str, char sep)
   -> Vector<std::string_view>;
 
+/**
+ * @brief splits the string with sep into several views,
+ * without touching the string.
+ *
+ * unlike split, the results are not zero-terminated; each
+ * of them is followed by sep or the end of str.
+ */
+auto splitView (std::string_view str, char sep)
+  -> Vector<std::string_view>;
+
 /// copies the strings in vec into an array of real strings.
 auto copyStrings (const Vector<std::string_view> &vec)
   -> Vector<std::string>;
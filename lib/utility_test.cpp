@@ -3,7 +3,7 @@
 #include <cassert>
 #include <vector>
 
-using ticket::split, ticket::copyStrings;
+using ticket::split, ticket::splitView, ticket::copyStrings;
 
 auto main () -> int {
   std::string str = "1926;0817;;hello;world;!!!!!";
@@ -20,5 +20,10 @@ auto main () -> int {
     assert(copy[i] == std[i]);
     assert(copy[i] == vec[i]);
   }
+  std::string line = "a|bc||def|";
+  auto views = splitView(line, '|');
+  assert(views.size() == 3);
+  assert(views[0] == "a" && views[1] == "bc" && views[2] == "def");
+  assert(line == "a|bc||def|");
   return 0;
 }
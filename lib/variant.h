@@ -67,7 +67,7 @@ class Variant {
       else new(&get_<Second>()) Second(move(other.get_<Second>()));
     } else {
       other.visit([this] (auto &value) {
-        using T = decltype(value);
+        using T = std::remove_cvref_t<decltype(value)>;
         new(&get_<T>()) T(move(value));
       });
     }
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <iterator>
 
+#include "allocator.h"
 #include "exception.h"
 #include "utility.h"
 
@@ -14,8 +15,9 @@ namespace ticket {
  * @brief A data container like std::vector
  *
  * store data in a successive memory and support random access.
+ * The memory comes from Alloc (see allocator.h).
  */
-template<typename T>
+template<typename T, typename Alloc = HeapAllocator>
 class Vector {
  public:
   class const_iterator;
@@ -176,7 +178,7 @@ class Vector {
   Vector (Vector &&other) noexcept { *this = move(other); }
   ~Vector () {
     destroyContents_();
-    delete[] reinterpret_cast<char *>(storage_);
+    deallocate_();
   }
   auto operator= (const Vector &other) -> Vector & {
     if (this == &other) return *this;
@@ -270,7 +272,7 @@ class Vector {
    */
   auto clear () -> void {
     destroyContents_();
-    delete[] reinterpret_cast<char *>(storage_);
+    deallocate_();
     storage_ = nullptr;
     capacity_ = 0;
     size_ = 0;
@@ -394,11 +396,15 @@ class Vector {
     }
   }
   auto destroyContents_ () -> void { destroyContents_(storage_, size_); }
+  auto deallocate_ () -> void {
+    if (storage_ != nullptr) Alloc::deallocate(storage_, capacity_ * kSzT_);
+  }
   auto grow_ (size_t capNew) -> void {
-    T *storeNew = reinterpret_cast<T *>(new char[capNew * kSzT_]);
+    T *storeNew = reinterpret_cast<T *>(
+      Alloc::allocate(capNew * kSzT_, alignof(T)));
     if (storage_ != nullptr) {
       moveContents_(storeNew, storage_, size_);
-      delete[] reinterpret_cast<char *>(storage_);
+      deallocate_();
     }
     storage_ = storeNew;
     capacity_ = capNew;
@@ -415,6 +421,10 @@ class Vector {
   }
 };
 
+/// A Vector of the temporaries of a command (see Arena).
+template <typename T>
+using ArenaVector = Vector<T, ArenaAllocator>;
+
 } // namespace ticket
 
 #endif // TICKET_LIB_VECTOR_H_
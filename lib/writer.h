@@ -0,0 +1,188 @@
+#ifndef TICKET_LIB_WRITER_H_
+#define TICKET_LIB_WRITER_H_
+
+#include <unistd.h>
+
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "datetime.h"
+#include "file/varchar.h"
+
+namespace ticket {
+
+/**
+ * @brief A buffered writer to a file descriptor.
+ *
+ * Integers, dates, instants and Varchars are formatted
+ * directly into one buffer, which is written out in a
+ * single call when it fills up, on flush() and on
+ * destruction. Nothing is allocated after construction,
+ * unless the output is captured into a string.
+ */
+class Writer {
+ public:
+  explicit Writer (int fd) : fd_(fd), buf_(new char[kSize]) {}
+  Writer (const Writer &) = delete;
+  auto operator= (const Writer &) -> Writer & = delete;
+  ~Writer () {
+    capture(nullptr);
+    flush();
+    delete[] buf_;
+    delete[] held_;
+  }
+
+  auto operator<< (char c) -> Writer & {
+    reserve_(1);
+    buf_[length_++] = c;
+    return *this;
+  }
+  auto operator<< (std::string_view str) -> Writer & {
+    if (str.length() > kSize) {
+      flush();
+      if (sink_ != nullptr) {
+        sink_->append(str);
+      } else {
+        write_(str.data(), str.length());
+      }
+      return *this;
+    }
+    reserve_(str.length());
+    memcpy(buf_ + length_, str.data(), str.length());
+    length_ += str.length();
+    return *this;
+  }
+  auto operator<< (const char *str) -> Writer & {
+    return *this << std::string_view(str);
+  }
+  template <std::integral Int>
+  auto operator<< (Int x) -> Writer & {
+    // enough for the digits of 64-bit integers and a sign.
+    reserve_(21);
+    unsigned long long abs = x;
+    if constexpr (std::signed_integral<Int>) {
+      if (x < 0) {
+        buf_[length_++] = '-';
+        abs = -abs;
+      }
+    }
+    char digits[20];
+    int n = 0;
+    do {
+      digits[n++] = '0' + abs % 10;
+      abs /= 10;
+    } while (abs != 0);
+    while (n > 0) buf_[length_++] = digits[--n];
+    return *this;
+  }
+  template <int maxLength>
+  auto operator<< (const file::Varchar<maxLength> &str) -> Writer & {
+    return *this << str.view();
+  }
+  /// writes the date in MM-DD format.
+  auto operator<< (Date date) -> Writer & {
+    reserve_(Date::kFormatLength);
+    date.format(buf_ + length_);
+    length_ += Date::kFormatLength;
+    return *this;
+  }
+  /// writes the instant in HH:MM format, without its overflow.
+  auto operator<< (Instant instant) -> Writer & {
+    reserve_(Instant::kFormatLength);
+    instant.format(buf_ + length_);
+    length_ += Instant::kFormatLength;
+    return *this;
+  }
+  /// writes the date and the time in formatDateTime format.
+  auto dateTime (Date date, Instant instant) -> Writer & {
+    return *this << date + instant.daysOverflow() << ' ' << instant;
+  }
+
+  // the binary output, as read by binary::Reader.
+
+  /// writes the n low bytes of x in little-endian.
+  auto raw (unsigned long long x, int n) -> Writer & {
+    reserve_(n);
+    for (int i = 0; i < n; ++i) buf_[length_++] = (char) (x >> (8 * i));
+    return *this;
+  }
+  auto u8 (unsigned x) -> Writer & { return raw(x, 1); }
+  auto u16 (unsigned x) -> Writer & { return raw(x, 2); }
+  auto u32 (uint32_t x) -> Writer & { return raw(x, 4); }
+  auto i32 (int32_t x) -> Writer & { return raw((uint32_t) x, 4); }
+  auto i64 (int64_t x) -> Writer & { return raw((uint64_t) x, 8); }
+  /// writes the string prefixed with its length.
+  auto string (std::string_view str) -> Writer & {
+    return u16(str.length()) << str;
+  }
+  /// writes the date and the time as 4 bytes: the month,
+  /// the day, the hour and the minute.
+  auto rawDateTime (Date date, Instant instant) -> Writer & {
+    auto day = date + instant.daysOverflow();
+    return u8(day.month()).u8(day.date())
+      .u8(instant.hour()).u8(instant.minute());
+  }
+
+  /// writes out the buffer.
+  auto flush () -> void {
+    if (sink_ != nullptr) {
+      sink_->append(buf_, length_);
+    } else {
+      write_(buf_, length_);
+    }
+    length_ = 0;
+  }
+  /**
+   * @brief appends the output to sink rather than writing
+   * it to the file, until capture(nullptr).
+   *
+   * the output pending for the file is held in the
+   * meantime, not written out.
+   */
+  auto capture (std::string *sink) -> void {
+    if (sink_ != nullptr) {
+      flush();
+      std::swap(buf_, held_);
+      length_ = heldLength_;
+    }
+    sink_ = sink;
+    if (sink_ != nullptr) {
+      if (held_ == nullptr) held_ = new char[kSize];
+      std::swap(buf_, held_);
+      heldLength_ = length_;
+      length_ = 0;
+    }
+  }
+
+ private:
+  static constexpr size_t kSize = 1 << 16;
+  int fd_;
+  char *buf_;
+  size_t length_ = 0;
+  std::string *sink_ = nullptr;
+  /// the buffer of the file while capturing, and the spare
+  /// buffer otherwise.
+  char *held_ = nullptr;
+  size_t heldLength_ = 0;
+
+  /// makes room for n more bytes.
+  auto reserve_ (size_t n) -> void {
+    if (length_ + n > kSize) flush();
+  }
+  auto write_ (const char *data, size_t n) -> void {
+    while (n > 0) {
+      auto written = ::write(fd_, data, n);
+      if (written <= 0) return;
+      data += written;
+      n -= written;
+    }
+  }
+};
+
+} // namespace ticket
+
+#endif // TICKET_LIB_WRITER_H_
@@ -0,0 +1,71 @@
+#include "writer.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "datetime.h"
+#include "file/varchar.h"
+
+using ticket::Date, ticket::Instant, ticket::Writer;
+using ticket::file::Varchar;
+
+auto readAll (const char *filename) -> std::string {
+  std::ifstream file(filename);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+auto main () -> int {
+  remove("test.out");
+  auto fd = open("test.out", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  assert(fd >= 0);
+  std::string expected;
+  {
+    Writer out(fd);
+    out << 0 << ' ' << -42 << ' ' << INT_MIN << ' ' << LLONG_MAX
+      << ' ' << (size_t) 7 << '\n';
+    expected += "0 -42 -2147483648 9223372036854775807 7\n";
+    out << Varchar<20>("G1234") << ' ' << std::string_view("abc")
+      << " def\n";
+    expected += "G1234 abc def\n";
+    out << Date(8, 17) << ' ' << Instant(9, 5) << ' ';
+    out.dateTime(Date(6, 30), Instant(23, 0) + ticket::Duration(90))
+      << '\n';
+    expected += "08-17 09:05 07-01 00:30\n";
+    // more than the buffer holds.
+    for (int i = 0; i < 20000; ++i) {
+      out << i << '\n';
+      expected += std::to_string(i) + '\n';
+    }
+    std::string large(100000, 'x');
+    out << large;
+    expected += large;
+
+    // captured output does not reach the file, and the
+    // output before it is held until the capture ends.
+    out << "before\n";
+    std::string captured;
+    out.capture(&captured);
+    out << 42 << ' ' << large << '\n';
+    out.capture(nullptr);
+    assert(captured == "42 " + large + "\n");
+    out.capture(&captured);
+    out << "again";
+    out.capture(nullptr);
+    assert(captured == "42 " + large + "\nagain");
+    out << "after\n";
+    expected += "before\nafter\n";
+  }
+  close(fd);
+  assert(readAll("test.out") == expected);
+  remove("test.out");
+  return 0;
+}
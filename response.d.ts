@@ -7,8 +7,23 @@ interface User {
   email: string
   privilege: number
 }
+/** Milliseconds since the Unix epoch, the wall clock taken as UTC. */
+type Time = number
+interface Stop {
+  station: string
+  /** null at the first stop. */
+  arrival: Time | null
+  /** null at the last stop. */
+  departure: Time | null
+  /** the price from the first stop. */
+  price: number
+  /** the seats to the next stop, null at the last stop. */
+  seats: number | null
+}
 interface Train {
-  // TODO
+  trainId: string
+  type: string
+  stops: Stop[]
 }
 interface BuyTicketSuccess {
   status: 'success'
@@ -18,20 +33,43 @@ interface BuyTicketEnqueued {
   status: 'enqueued'
 }
 type BuyTicketResponse = BuyTicketSuccess | BuyTicketEnqueued
-interface Order {
-  id: number
+interface Range {
   trainId: string
-  from: Date
-  to: Date
+  from: string
+  departure: Time
+  to: string
+  arrival: Time
   price: number
   seats: number
+}
+interface Order extends Range {
+  status: 'success' | 'pending' | 'refunded'
   subTotal: number
 }
+/**
+ * A list too long to convert row by row, in the binary
+ * protocol (see src/protocol.h). Use rows() to read it.
+ */
+interface PackedRows<Type extends string> {
+  type: Type
+  length: number
+  buffer: ArrayBuffer
+}
+export type Orders = Order[] | PackedRows<'orders'>
+export type Ranges = Range[] | PackedRows<'ranges'>
 
 export type Response =
   Success |
   User |
   Train |
-  Train[] |
   BuyTicketResponse |
-  Order[]
+  Orders |
+  Ranges
+
+/** The rows of a list, decoding packed rows on access. */
+export interface Rows<T> extends Iterable<T> {
+  readonly length: number
+  at (index: number): T
+}
+export function rows (orders: Orders): Rows<Order>
+export function rows (ranges: Ranges): Rows<Range>
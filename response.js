@@ -0,0 +1,107 @@
+// Reads the lists returned by the Node binding, decoding
+// the packed ones lazily. See toJsObject() in
+// src/response.cpp, and response.d.ts.
+'use strict'
+
+const decoder = new TextDecoder()
+const statuses = [ 'success', 'pending', 'refunded' ]
+
+class Reader {
+  constructor (buffer, pos) {
+    this.view = new DataView(buffer)
+    this.bytes = new Uint8Array(buffer)
+    this.pos = pos
+  }
+  u8 () { return this.view.getUint8(this.pos++) }
+  u16 () {
+    const x = this.view.getUint16(this.pos, true)
+    this.pos += 2
+    return x
+  }
+  i32 () {
+    const x = this.view.getInt32(this.pos, true)
+    this.pos += 4
+    return x
+  }
+  i64 () {
+    const x = Number(this.view.getBigInt64(this.pos, true))
+    this.pos += 8
+    return x
+  }
+  string () {
+    const length = this.u16()
+    this.pos += length
+    return decoder.decode(this.bytes.subarray(this.pos - length, this.pos))
+  }
+  skipString () {
+    const length = this.u16()
+    this.pos += length
+  }
+  // month, day, hour and minute, see Writer::rawDateTime().
+  time () {
+    const [ month, day, hour, minute ] = this.bytes.subarray(this.pos, this.pos += 4)
+    return Date.UTC(2021, month - 1, day, hour, minute)
+  }
+}
+
+const readRange = (r, row) => {
+  row.trainId = r.string()
+  row.from = r.string()
+  row.departure = r.time()
+  row.to = r.string()
+  row.arrival = r.time()
+  row.price = r.i64()
+  row.seats = r.i32()
+  return row
+}
+const skipRange = r => {
+  r.skipString()
+  r.skipString()
+  r.pos += 4
+  r.skipString()
+  r.pos += 4 + 8 + 4
+}
+const schemas = {
+  orders: {
+    read: r => {
+      const row = readRange(r, { status: statuses[r.u8()] })
+      row.subTotal = row.price * row.seats
+      return row
+    },
+    skip: r => {
+      r.pos += 1
+      skipRange(r)
+    },
+  },
+  ranges: { read: r => readRange(r, {}), skip: skipRange },
+}
+
+class PackedRows {
+  constructor ({ type, length, buffer }) {
+    this.schema = schemas[type]
+    this.length = length
+    this.buffer = buffer
+    // the positions of the rows, found on the first access.
+    this.offsets = null
+  }
+  at (index) {
+    if (this.offsets === null) this.index()
+    return this.schema.read(new Reader(this.buffer, this.offsets[index]))
+  }
+  index () {
+    this.offsets = new Uint32Array(this.length)
+    // after the number of rows.
+    const r = new Reader(this.buffer, 4)
+    for (let i = 0; i < this.length; ++i) {
+      this.offsets[i] = r.pos
+      this.schema.skip(r)
+    }
+  }
+  * [Symbol.iterator] () {
+    for (let i = 0; i < this.length; ++i) yield this.at(i)
+  }
+}
+
+const rows = list => Array.isArray(list) ? list : new PackedRows(list)
+
+module.exports = { rows }
@@ -0,0 +1,79 @@
+#include "input.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace ticket {
+
+InputReader::InputReader (int fd, Protocol protocol)
+  : fd_(fd), protocol_(protocol), thread_([this] { run_(); }) {}
+
+InputReader::~InputReader () {
+  thread_.join();
+}
+
+auto InputReader::run_ () -> void {
+  size_t capacity = kBlock;
+  auto buf = new char[capacity];
+  // the bytes read but not emitted yet.
+  size_t begin = 0, end = 0;
+  while (true) {
+    std::string_view body;
+    auto length = splitFrame(protocol_,
+      std::string_view(buf + begin, end - begin), body);
+    if (length != 0) {
+      if (!emit_(body)) break;
+      begin += length;
+      continue;
+    }
+
+    // moves the partial request to the front, and reads more.
+    memmove(buf, buf + begin, end - begin);
+    end -= begin;
+    begin = 0;
+    if (end == capacity) {
+      auto larger = new char[capacity * 2];
+      memcpy(larger, buf, end);
+      delete[] buf;
+      buf = larger;
+      capacity *= 2;
+    }
+    auto n = read(fd_, buf + end, capacity - end);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      if (end > 0) {
+        // the last line may have no newline, while a partial
+        // binary frame is an error.
+        if (protocol_ == Protocol::kText) {
+          if (!emit_({ buf, end })) break;
+        } else {
+          auto &frame = ring_.acquire();
+          frame.eof = false;
+          frame.parsed = false;
+          ring_.publish();
+          break;
+        }
+      }
+      auto &frame = ring_.acquire();
+      frame.eof = true;
+      ring_.publish();
+      break;
+    }
+    end += n;
+  }
+  delete[] buf;
+}
+
+auto InputReader::emit_ (std::string_view body) -> bool {
+  if (protocol_ == Protocol::kText && body.empty()) return true;
+  auto &frame = ring_.acquire();
+  readFrame(protocol_, body, frame);
+  bool last = !frame.parsed
+    || frame.cmd.get<command::Exit>() != nullptr;
+  ring_.publish();
+  return !last;
+}
+
+} // namespace ticket
@@ -0,0 +1,56 @@
+// This file reads and parses commands ahead of the REPL.
+#ifndef TICKET_INPUT_H_
+#define TICKET_INPUT_H_
+
+#include <string>
+#include <thread>
+
+#include "protocol.h"
+#include "spsc-ring.h"
+
+namespace ticket {
+
+/**
+ * @brief Reads the frames of fd on a thread of its own.
+ *
+ * The thread reads fd in large blocks, splits them into
+ * requests in the given protocol, and parses the commands, staying up to kAhead frames ahead of the
+ * consumer. It stops after the end of the input, a command
+ * failing to parse, or the exit command, so there is
+ * nothing left to read when the consumer stops at one of
+ * them.
+ */
+class InputReader {
+ public:
+  InputReader (int fd, Protocol protocol);
+  InputReader (const InputReader &) = delete;
+  auto operator= (const InputReader &) -> InputReader & = delete;
+  ~InputReader ();
+
+  /// waits for the next frame, valid until pop().
+  auto front () -> Frame & { return ring_.front(); }
+  /// gets the number of frames parsed by now.
+  auto ready () const -> size_t { return ring_.ready(); }
+  /// gets the i-th frame, i < ready().
+  auto at (size_t i) -> Frame & { return ring_.at(i); }
+  /// drops the first n frames.
+  auto pop (size_t n = 1) -> void { ring_.release(n); }
+
+ private:
+  static constexpr size_t kAhead = 1 << 10;
+  static constexpr size_t kBlock = 1 << 20;
+  int fd_;
+  Protocol protocol_;
+  SpscRing<Frame, kAhead> ring_;
+  std::thread thread_;
+
+  /// the body of the thread.
+  auto run_ () -> void;
+  /// parses a request into the next frame, false if it is
+  /// the last one to read.
+  auto emit_ (std::string_view body) -> bool;
+};
+
+} // namespace ticket
+
+#endif // TICKET_INPUT_H_
@@ -0,0 +1,412 @@
+// This file implements the multi-leg journey planner.
+#include "journey.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "algorithm.h"
+#include "datetime.h"
+#include "hashmap.h"
+#include "optional.h"
+#include "parser.h"
+#include "run.h"
+#include "train.h"
+#include "utility.h"
+#include "vector.h"
+
+namespace ticket {
+
+namespace {
+
+constexpr int kMinutesInDay = 24 * 60;
+/// the maximum number of transfers a query may ask for.
+constexpr int kMaxTransfers = 5;
+/// all dates in the timetable are in days since this date.
+const Date kEpoch(6, 1);
+
+auto minutesOf (Instant instant) -> int {
+  return (instant - Instant(0, 0)).minutes();
+}
+/// integer division rounding towards positive infinity.
+auto divCeil (int a, int b) -> int {
+  return a >= 0 ? (a + b - 1) / b : -(-a / b);
+}
+
+/**
+ * @brief The compact in-memory timetable.
+ *
+ * Every released train becomes a route, and every stop of
+ * the route is stored in one big array. Times are stored
+ * in minutes since 00:00 of the departure date of the
+ * train, and prices are cumulative from the first stop, so
+ * that a segment is just a subtraction away.
+ */
+class Timetable {
+ public:
+  struct Stop {
+    int station;
+    int arrival, departure;
+    long long price;
+  };
+  struct Route {
+    int train;
+    Train::Id trainId;
+    /// the first and the last departure dates of the train.
+    int begin, end;
+    /// index of the first stop of this route in stops.
+    int first;
+    int length;
+  };
+  /// a route calling at a station.
+  struct Visit {
+    int route;
+    int ixStop;
+  };
+
+  Vector<Route> routes;
+  Vector<Stop> stops;
+  /// routes calling at each station.
+  Vector<Vector<Visit>> visits;
+
+  auto stop (const Route &route, int ix) const -> const Stop & {
+    return stops[route.first + ix];
+  }
+  auto station (std::string_view name) const
+    -> Optional<int> {
+    auto it = stationIds_.find(std::hash<std::string_view>()(name));
+    if (it == stationIds_.cend()) return unit;
+    return it->second;
+  }
+  auto stationCount () const -> int {
+    return visits.size();
+  }
+
+  /**
+   * @brief builds the timetable if it is stale.
+   *
+   * the queries may call it on several threads at once.
+   */
+  auto ensureBuilt () -> void {
+    if (!stale_.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lock(building_);
+    if (!stale_.load(std::memory_order_relaxed)) return;
+    routes.clear();
+    stops.clear();
+    visits.clear();
+    stationIds_.clear();
+    auto entries = Train::ixStop.findAll();
+    auto ids = entries.map([] (const auto &entry) {
+      return entry.second;
+    });
+    sort(ids.begin(), ids.end());
+    for (int i = 0; i < ids.size(); ++i) {
+      if (i > 0 && ids[i] == ids[i - 1]) continue;
+      add_(Train::get(ids[i]));
+    }
+    stale_.store(false, std::memory_order_release);
+  }
+  auto add (const Train &train) -> void {
+    if (!stale_.load(std::memory_order_relaxed)) add_(train);
+  }
+  auto invalidate () -> void {
+    stale_.store(true, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<bool> stale_ = true;
+  std::mutex building_;
+  HashMap<size_t, int> stationIds_;
+
+  auto stationId_ (size_t hash) -> int {
+    auto [ it, inserted ] =
+      stationIds_.insert({ hash, (int) visits.size() });
+    if (inserted) visits.push_back({});
+    return it->second;
+  }
+  auto add_ (const Train &train) -> void {
+    Route route;
+    route.train = train.id();
+    route.trainId = train.trainId;
+    route.begin = train.begin - kEpoch;
+    route.end = train.end - kEpoch;
+    route.first = stops.size();
+    route.length = train.stops.length;
+    int ixRoute = routes.size();
+    for (int i = 0; i < route.length; ++i) {
+      Stop stop;
+      stop.station = stationId_(train.stops[i].hash());
+      stop.arrival =
+        i == 0 ? 0 : minutesOf(train.edges[i - 1].arrival);
+      stop.departure = i + 1 == route.length
+        ? 0 : minutesOf(train.edges[i].departure);
+      stop.price = train.prices[i];
+      stops.push_back(stop);
+      visits[stop.station].push_back({ ixRoute, i });
+    }
+    routes.push_back(route);
+  }
+};
+Timetable timetable;
+
+/**
+ * @brief A McRAPTOR-style round-based journey search.
+ *
+ * Round k finds journeys of exactly k legs. Each station
+ * keeps a bag of Pareto-optimal labels on (arrival time,
+ * departure time, price, legs); a label is discarded if
+ * another label arrives no later, departs no earlier,
+ * costs no more and takes no more legs. Labels dominated
+ * by a journey already found at the destination are pruned
+ * as well.
+ */
+class Planner {
+ public:
+  struct Label {
+    int station;
+    /// absolute times in minutes since kEpoch.
+    int departure, arrival;
+    long long price;
+    int legs;
+    /// the label of the previous leg, or -1.
+    int parent;
+    int route, ixFrom, ixTo;
+    /// the departure date of the ride of this leg.
+    int day;
+    bool dead = false;
+  };
+
+  Planner (const Timetable &tt, int to, command::SortType sort)
+    : tt_(tt), to_(to), sort_(sort) {
+    bags_.reserve(tt.stationCount());
+    for (int i = 0; i < tt.stationCount(); ++i) {
+      bags_.push_back({});
+    }
+  }
+
+  /// finds the best journey departing from `from` on date.
+  auto run (int from, int date, int transfers) -> Optional<int> {
+    Vector<int> frontier;
+    for (const auto &visit : tt_.visits[from]) {
+      const auto &route = tt_.routes[visit.route];
+      if (visit.ixStop + 1 == route.length) continue;
+      int departure = tt_.stop(route, visit.ixStop).departure;
+      int day = date - departure / kMinutesInDay;
+      if (day < route.begin || day > route.end) continue;
+      ride_(-1, visit.route, visit.ixStop, day, frontier);
+    }
+    for (int k = 0; k < transfers && !frontier.empty(); ++k) {
+      Vector<int> next;
+      for (int ixLabel : frontier) {
+        if (labels_[ixLabel].dead) continue;
+        transfer_(ixLabel, next);
+      }
+      frontier = move(next);
+    }
+    return best_();
+  }
+
+  /// reconstructs the legs of the journey ending at label.
+  auto legs (int ixLabel) const -> Vector<Range> {
+    Vector<int> chain;
+    for (int i = ixLabel; i != -1; i = labels_[i].parent) {
+      chain.push_back(i);
+    }
+    Vector<Range> res;
+    res.reserve(chain.size());
+    for (int i = chain.size() - 1; i >= 0; --i) {
+      const auto &label = labels_[chain[i]];
+      const auto &route = tt_.routes[label.route];
+      auto rd = *RideSeats::ixRide.findOne({
+        route.train,
+        kEpoch + label.day,
+      });
+      const auto &from = tt_.stop(route, label.ixFrom);
+      const auto &to = tt_.stop(route, label.ixTo);
+      res.push_back(Range(
+        rd, label.ixFrom, label.ixTo,
+        to.price - from.price,
+        Duration(to.arrival - from.departure),
+        rd.ticketsAvailable(label.ixFrom, label.ixTo),
+        route.trainId
+      ));
+    }
+    return res;
+  }
+
+ private:
+  const Timetable &tt_;
+  int to_;
+  command::SortType sort_;
+  Vector<Label> labels_;
+  /// Pareto-optimal labels at each station.
+  Vector<Vector<int>> bags_;
+
+  static auto dominates_ (const Label &lhs, const Label &rhs)
+    -> bool {
+    bool noWorse = lhs.arrival <= rhs.arrival &&
+      lhs.departure >= rhs.departure &&
+      lhs.price <= rhs.price &&
+      lhs.legs <= rhs.legs;
+    bool better = lhs.arrival < rhs.arrival ||
+      lhs.departure > rhs.departure ||
+      lhs.price < rhs.price ||
+      lhs.legs < rhs.legs;
+    return noWorse && better;
+  }
+
+  /// rides from ixFrom on the given day, adding a label at every later stop.
+  auto ride_ (
+    int parent,
+    int ixRoute,
+    int ixFrom,
+    int day,
+    Vector<int> &out
+  ) -> void {
+    const auto &route = tt_.routes[ixRoute];
+    const auto &from = tt_.stop(route, ixFrom);
+    int departure = parent == -1
+      ? day * kMinutesInDay + from.departure
+      : labels_[parent].departure;
+    long long price = parent == -1 ? 0 : labels_[parent].price;
+    int legs = parent == -1 ? 1 : labels_[parent].legs + 1;
+    for (int i = ixFrom + 1; i < route.length; ++i) {
+      const auto &stop = tt_.stop(route, i);
+      Label label;
+      label.station = stop.station;
+      label.departure = departure;
+      label.arrival = day * kMinutesInDay + stop.arrival;
+      label.price = price + stop.price - from.price;
+      label.legs = legs;
+      label.parent = parent;
+      label.route = ixRoute;
+      label.ixFrom = ixFrom;
+      label.ixTo = i;
+      label.day = day;
+      // arrival and price only grow along the route, so if
+      // the destination has a better journey, so it has for
+      // the rest of the stops.
+      if (prunedByTarget_(label)) return;
+      add_(label, out);
+    }
+  }
+  /// transfers from a label to every route calling at its station.
+  auto transfer_ (int ixLabel, Vector<int> &out) -> void {
+    // copied since labels_ may grow in ride_.
+    Label label = labels_[ixLabel];
+    int train = tt_.routes[label.route].train;
+    for (const auto &visit : tt_.visits[label.station]) {
+      const auto &route = tt_.routes[visit.route];
+      // cannot transfer to the same train.
+      if (route.train == train) continue;
+      if (visit.ixStop + 1 == route.length) continue;
+      int departure = tt_.stop(route, visit.ixStop).departure;
+      int day = divCeil(label.arrival - departure, kMinutesInDay);
+      if (day < route.begin) day = route.begin;
+      if (day > route.end) continue;
+      ride_(ixLabel, visit.route, visit.ixStop, day, out);
+    }
+  }
+  auto prunedByTarget_ (const Label &label) const -> bool {
+    // any journey continuing this label arrives no earlier
+    // and costs no less, so the number of legs does not
+    // matter here.
+    for (int ix : bags_[to_]) {
+      const auto &target = labels_[ix];
+      bool noWorse = target.arrival <= label.arrival &&
+        target.departure >= label.departure &&
+        target.price <= label.price;
+      bool better = target.arrival < label.arrival ||
+        target.departure > label.departure ||
+        target.price < label.price;
+      if (noWorse && better) return true;
+    }
+    return false;
+  }
+  auto add_ (const Label &label, Vector<int> &out) -> void {
+    auto &bag = bags_[label.station];
+    for (int ix : bag) {
+      if (dominates_(labels_[ix], label)) return;
+    }
+    Vector<int> kept;
+    for (int ix : bag) {
+      if (dominates_(label, labels_[ix])) {
+        labels_[ix].dead = true;
+      } else {
+        kept.push_back(ix);
+      }
+    }
+    int ixLabel = labels_.size();
+    labels_.push_back(label);
+    kept.push_back(ixLabel);
+    bag = move(kept);
+    // there is no point in going further from the destination.
+    if (label.station != to_) out.push_back(ixLabel);
+  }
+
+  auto trainIds_ (int ixLabel) const -> Vector<std::string> {
+    Vector<std::string> res;
+    for (int i = ixLabel; i != -1; i = labels_[i].parent) {
+      res.push_back(tt_.routes[labels_[i].route].trainId.str());
+    }
+    Vector<std::string> reversed;
+    reversed.reserve(res.size());
+    for (int i = res.size() - 1; i >= 0; --i) {
+      reversed.push_back(res[i]);
+    }
+    return reversed;
+  }
+  auto better_ (int lhs, int rhs) const -> bool {
+    const auto &l = labels_[lhs];
+    const auto &r = labels_[rhs];
+    int timeL = l.arrival - l.departure;
+    int timeR = r.arrival - r.departure;
+    if (sort_ == command::kTime) {
+      if (timeL != timeR) return timeL < timeR;
+      if (l.price != r.price) return l.price < r.price;
+    } else {
+      if (l.price != r.price) return l.price < r.price;
+      if (timeL != timeR) return timeL < timeR;
+    }
+    auto idsL = trainIds_(lhs);
+    auto idsR = trainIds_(rhs);
+    for (int i = 0; i < idsL.size() && i < idsR.size(); ++i) {
+      if (idsL[i] != idsR[i]) return idsL[i] < idsR[i];
+    }
+    return idsL.size() < idsR.size();
+  }
+  auto best_ () const -> Optional<int> {
+    Optional<int> res;
+    for (int ix : bags_[to_]) {
+      if (!res || better_(ix, *res)) res = ix;
+    }
+    return res;
+  }
+};
+
+} // namespace
+
+auto journey::addTrain (const Train &train) -> void {
+  timetable.add(train);
+}
+auto journey::invalidate () -> void {
+  timetable.invalidate();
+}
+
+auto command::run (const command::QueryJourney &cmd)
+  -> Result<Response, Exception> {
+  if (cmd.transfers < 0 || cmd.transfers > kMaxTransfers) {
+    return Exception("invalid number of transfers");
+  }
+  timetable.ensureBuilt();
+  Journey journey;
+  auto from = timetable.station(cmd.from);
+  auto to = timetable.station(cmd.to);
+  if (!from || !to || *from == *to) return journey;
+
+  Planner planner(timetable, *to, cmd.sort);
+  auto best = planner.run(*from, cmd.date - kEpoch, cmd.transfers);
+  if (best) journey.legs = planner.legs(*best);
+  return journey;
+}
+
+} // namespace ticket
@@ -0,0 +1,43 @@
+#ifndef TICKET_JOURNEY_H_
+#define TICKET_JOURNEY_H_
+
+#include "train.h"
+#include "vector.h"
+
+namespace ticket {
+
+/**
+ * @brief The result of a journey query.
+ *
+ * A journey is a list of rides, where each ride departs
+ * after the previous one arrives, at the station where the
+ * previous one arrives. An empty journey means that no
+ * route is found.
+ */
+struct Journey {
+  Vector<Range> legs;
+};
+
+/**
+ * @brief The multi-leg journey planner.
+ *
+ * The planner works on a compact in-memory timetable built
+ * from the released trains. The timetable is built lazily
+ * on the first query, and needs to be kept in sync by the
+ * commands changing the set of released trains.
+ */
+namespace journey {
+
+/// adds a newly released train to the timetable.
+auto addTrain (const Train &train) -> void;
+/**
+ * @brief marks the timetable as stale, so that it is
+ * rebuilt on the next query.
+ */
+auto invalidate () -> void;
+
+} // namespace journey
+
+} // namespace ticket
+
+#endif // TICKET_JOURNEY_H_
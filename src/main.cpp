@@ -1,60 +1,107 @@
 // This is the entrypoint of the backend program.
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
+#include "input.h"
 #include "parser.h"
+#include "protocol.h"
 #include "response.h"
 #include "rollback.h"
-#include "run.h"
+#include "scheduler.h"
+#include "server.h"
 #include "utility.h"
 
-auto main () -> int {
-#ifdef ONLINE_JUDGE
-  std::ios_base::sync_with_stdio(false);
-  std::cin.tie(nullptr);
-  std::cout.tie(nullptr);
-#endif // ONLINE_JUDGE
-// freopen("../tests/rollback/basic_3/7.in", "r", stdin);
+namespace {
 
-  while (true) {
-    // parse timestamp
-    char c1 = (char) std::cin.get();
-    TICKET_ASSERT(c1 == '[');
-    int timestamp;
-    std::cin >> timestamp;
-    ticket::setTimestamp(timestamp);
-    char c2 = (char) std::cin.get();
-    TICKET_ASSERT(c2 == ']');
-    std::cout << '[' << timestamp << "] ";
+/// the most threads to run queries on by default.
+constexpr int kMaxThreads = 8;
+/// the most queries to run in one batch.
+constexpr size_t kBatch = 256;
+
+} // namespace
 
-    // main command
-    std::string input;
-    std::getline(std::cin, input);
-    auto cmd = ticket::command::parse(input);
-    if (auto err = cmd.error()) {
-      ;// std::cerr << err->what() << std::endl;
+auto main (int argc, char **argv) -> int {
+  const char *socketPath = nullptr;
+  auto protocol = ticket::Protocol::kText;
+  int threads = std::min((int) std::thread::hardware_concurrency(),
+    kMaxThreads) - 1;
+  for (int i = 1; i < argc; ++i) {
+    // --rollback-window <w>: rollbacks reach back at most w.
+    // --listen <path>: serves clients on a socket, not stdin.
+    // --threads <n>: runs queries on n more threads.
+    // --binary: speaks the binary protocol, see Protocol.
+    if (strcmp(argv[i], "--rollback-window") == 0 && i + 1 < argc) {
+      ticket::rollback::setRetention(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--binary") == 0) {
+      protocol = ticket::Protocol::kBinary;
+    } else {
+      std::cerr << "Unknown argument: " << argv[i] << std::endl;
       return 1;
     }
-
-    cmd.result().visit([] (const auto &args) {
-      auto res = ticket::command::run(args);
-      if (res.error()) {
-        if constexpr (ticket::isInteractive) {
-          std::cout << "\x1b[31m" << res.error()->what()
-            << "\x1b[0m\n";
-        } else {
-          std::cout << "-1\n";
-        }
+  }
+  ticket::Scheduler scheduler(threads, protocol);
+  if (socketPath != nullptr) {
+    return ticket::serve(socketPath, protocol, scheduler);
+  }
+  // the input is read and parsed on another thread, ahead
+  // of the commands run here.
+  ticket::InputReader input(STDIN_FILENO, protocol);
+  auto &out = ticket::response::out;
+  ticket::Frame *batch[kBatch];
+  while (true) {
+    auto &frame = input.front();
+    if (frame.eof) return 0;
+    if (frame.parsed && ticket::command::isReadOnly(frame.cmd)) {
+      // the queries parsed by now run together.
+      size_t n = 0, ready = std::min(input.ready(), kBatch);
+      while (n < ready) {
+        auto &next = input.at(n);
+        if (!next.parsed || !ticket::command::isReadOnly(next.cmd)) break;
+        ticket::setTimestamp(next.timestamp);
+        batch[n++] = &next;
+      }
+      scheduler.runReads(batch, n);
+      for (size_t i = 0; i < n; ++i) ticket::writeReply(protocol, *batch[i]);
+      input.pop(n);
+      if constexpr (ticket::isInteractive) out.flush();
+      continue;
+    }
+    ticket::setTimestamp(frame.timestamp);
+    if (protocol == ticket::Protocol::kBinary) {
+      // the reply is framed with its length, so it is
+      // written aside first.
+      frame.reply.clear();
+      out.capture(&frame.reply);
+      if (!frame.parsed) {
+        ticket::writeParseError(protocol);
+      } else if (frame.cmd.is<ticket::command::Exit>()) {
+        ticket::writeBye(protocol);
       } else {
-        if constexpr (ticket::isInteractive) {
-          std::cout << "\x1b[32m";
-        }
-        res.result().visit([] (const auto &res) {
-          ticket::response::cout(res);
-        });
-        if constexpr (ticket::isInteractive) {
-          std::cout << "\x1b[0m";
-        }
+        ticket::execute(protocol, frame.cmd);
       }
-    });
+      out.capture(nullptr);
+      ticket::writeReply(protocol, frame);
+      if (!frame.parsed) return 1;
+      if (frame.cmd.is<ticket::command::Exit>()) return 0;
+      input.pop();
+      if constexpr (ticket::isInteractive) out.flush();
+      continue;
+    }
+    out << '[' << frame.timestamp << "] ";
+    if (!frame.parsed) return 1;
+    ticket::execute(protocol, frame.cmd);
+    input.pop();
+    // the output is only flushed when the buffer is full,
+    // unless someone is reading it.
+    if constexpr (ticket::isInteractive) out.flush();
   }
 }
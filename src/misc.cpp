@@ -1,9 +1,9 @@
 // This file implements the clean and exit commands.
 #include "run.h"
 
-#include <iostream>
-
+#include "journey.h"
 #include "order.h"
+#include "response.h"
 #include "rollback.h"
 #include "train.h"
 #include "user.h"
@@ -12,10 +12,11 @@ namespace ticket {
 
 auto command::run (const command::Clean & /* unused */)
   -> Result<Response, Exception> {
+  rollback::clearLog();
+  User::clearSessions();
   Order::truncate();
   Order::ixUserId.truncate();
   Order::pendingOrders.truncate();
-  rollback::LogEntry::truncate();
   Train::truncate();
   Train::ixId.truncate();
   Train::ixStop.truncate();
@@ -23,11 +24,12 @@ auto command::run (const command::Clean & /* unused */)
   RideSeats::ixRide.truncate();
   User::truncate();
   User::ixUsername.truncate();
+  journey::invalidate();
   return unit;
 }
 auto command::run (const command::Exit & /* unused */)
   -> Result<Response, Exception> {
-  std::cout << "bye\n";
+  response::out << "bye\n";
   exit(0);
 }
 
@@ -0,0 +1,132 @@
+#include "node-queue.h"
+
+#include "rollback.h"
+
+namespace ticket::node {
+
+auto Job::OnOK () -> void {
+  deferred_.Resolve(result_());
+  JobQueue::finish(this);
+}
+
+auto Job::OnError (const Napi::Error &error) -> void {
+  deferred_.Reject(error.Value());
+  JobQueue::finish(this);
+}
+
+BatchJob::BatchJob (Napi::Env env, std::string_view requests)
+  : Job(env, true), responses_(new std::string) {
+  std::string_view body;
+  while (auto length = splitFrame(Protocol::kBinary, requests, body)) {
+    auto *frame = new Frame;
+    readFrame(Protocol::kBinary, body, *frame);
+    frames_.push_back(frame);
+    if (!frame->parsed || !command::isReadOnly(frame->cmd)) {
+      readOnly_ = false;
+    }
+    requests.remove_prefix(length);
+  }
+}
+
+BatchJob::~BatchJob () {
+  for (auto *frame : frames_) delete frame;
+  delete responses_;
+}
+
+auto BatchJob::Execute () -> void {
+  auto &out = response::out;
+  for (auto *frame : frames_) {
+    frame->reply.clear();
+    out.capture(&frame->reply);
+    if (!frame->parsed) {
+      writeParseError(Protocol::kBinary);
+    } else if (frame->cmd.is<command::Exit>()) {
+      writeBye(Protocol::kBinary);
+    } else {
+      // the timestamps only matter to the writes, which run
+      // alone.
+      if (!readOnly_) setTimestamp(frame->timestamp);
+      execute(Protocol::kBinary, frame->cmd);
+    }
+    out.capture(responses_);
+    writeReply(Protocol::kBinary, *frame);
+    out.capture(nullptr);
+  }
+}
+
+auto BatchJob::result_ () -> Napi::Value {
+  // the buffer takes the string over, with no copy.
+  auto *responses = responses_;
+  responses_ = nullptr;
+  return Napi::Buffer<char>::New(Env(), responses->data(),
+    responses->length(), [] (Napi::Env, char *, std::string *str) {
+      delete str;
+    }, responses);
+}
+
+auto ExitJob::OnOK () -> void {
+  // the queue is never resumed, so nothing runs while the
+  // process exits.
+  deferred_.Resolve(result_());
+  // exits after the callbacks of the Promise.
+  auto env = Env();
+  auto global = env.Global();
+  auto process = global.Get("process").As<Napi::Object>();
+  auto exit = process.Get("exit").As<Napi::Function>();
+  auto bind = exit.Get("bind").As<Napi::Function>();
+  global.Get("setImmediate").As<Napi::Function>().Call({
+    bind.Call(exit, { process }), Napi::Number::New(env, 0),
+  });
+}
+
+auto ExitJob::result_ () -> Napi::Value {
+  return response::toJsObject(Env(), unit);
+}
+
+auto execBatch (const Napi::CallbackInfo &info) -> Napi::Value {
+  auto array = info[0].As<Napi::Uint8Array>();
+  auto *job = new BatchJob(info.Env(),
+    { (const char *) array.Data(), array.ByteLength() });
+  return JobQueue::submit(job);
+}
+
+Vector<Job *> JobQueue::pending_;
+size_t JobQueue::head_ = 0;
+int JobQueue::reads_ = 0;
+bool JobQueue::writing_ = false;
+
+auto JobQueue::submit (Job *job) -> Napi::Promise {
+  auto promise = job->promise();
+  pending_.push_back(job);
+  pump_();
+  return promise;
+}
+
+auto JobQueue::finish (const Job *job) -> void {
+  if (job->readOnly()) {
+    --reads_;
+  } else {
+    writing_ = false;
+  }
+  pump_();
+}
+
+auto JobQueue::pump_ () -> void {
+  while (head_ < pending_.size() && !writing_) {
+    auto *job = pending_[head_];
+    if (!job->readOnly() && reads_ > 0) break;
+    ++head_;
+    if (job->readOnly()) {
+      ++reads_;
+    } else {
+      writing_ = true;
+    }
+    job->Queue();
+  }
+  if (head_ == pending_.size()) {
+    pending_.clear();
+    head_ = 0;
+  }
+}
+
+} // namespace ticket::node
@@ -0,0 +1,167 @@
+// This file runs the commands of the Node binding off the
+// main thread.
+#ifndef TICKET_NODE_QUEUE_H_
+#define TICKET_NODE_QUEUE_H_
+
+#ifndef BUILD_NODEJS
+#error "This file only works in Node builds"
+#endif // BUILD_NODEJS
+
+#include <napi.h>
+
+#include <string>
+#include <string_view>
+
+#include "exception.h"
+#include "protocol.h"
+#include "response.h"
+#include "run.h"
+#include "vector.h"
+
+namespace ticket::node {
+
+/**
+ * @brief A command submitted from JS, run on the thread
+ * pool of libuv and settling a Promise.
+ *
+ * The jobs go through JobQueue, so they run in the order
+ * they are submitted as far as the results can tell.
+ */
+class Job : public Napi::AsyncWorker {
+ public:
+  Job (Napi::Env env, bool readOnly)
+    : Napi::AsyncWorker(env, "ticket"),
+      deferred_(Napi::Promise::Deferred::New(env)),
+      readOnly_(readOnly) {}
+
+  auto promise () -> Napi::Promise { return deferred_.Promise(); }
+  auto readOnly () const -> bool { return readOnly_; }
+
+ protected:
+  Napi::Promise::Deferred deferred_;
+  bool readOnly_;
+
+  auto OnOK () -> void override;
+  auto OnError (const Napi::Error &error) -> void override;
+  /// converts the result to JS, after Execute() succeeds.
+  virtual auto result_ () -> Napi::Value = 0;
+};
+
+/**
+ * @brief A job running the command read by Args.
+ *
+ * Args holds the command and the strings it views, see
+ * node.cpp. The job is never moved, so the views stay
+ * valid.
+ */
+template <typename Args>
+class CommandJob : public Job {
+ public:
+  explicit CommandJob (Napi::Env env) : Job(env, Args::readOnly) {}
+
+  Args args;
+
+ protected:
+  auto Execute () -> void override {
+    try {
+      auto res = command::run(args.cmd);
+      if (auto err = res.error()) {
+        SetError(err->what());
+        return;
+      }
+      response_ = std::move(res.result());
+    } catch (const Exception &e) {
+      SetError(e.what());
+    }
+  }
+  auto result_ () -> Napi::Value override {
+    auto env = Env();
+    Napi::Value value;
+    response_.visit([&env, &value] (const auto &res) {
+      value = response::toJsObject(env, res);
+    });
+    return value;
+  }
+
+ private:
+  Response response_;
+};
+
+/**
+ * @brief A job running a batch of requests in the binary
+ * protocol back to back, see protocol.h.
+ *
+ * The requests are copied and parsed on the main thread,
+ * and the responses are handed to JS as one Buffer. A
+ * request failing to parse gets an error, and exit gets
+ * bye without exiting, the rest of the batch still
+ * running. The batch counts as a write unless all of its
+ * commands are queries.
+ */
+class BatchJob : public Job {
+ public:
+  BatchJob (Napi::Env env, std::string_view requests);
+  ~BatchJob () override;
+
+ protected:
+  auto Execute () -> void override;
+  auto result_ () -> Napi::Value override;
+
+ private:
+  Vector<Frame *> frames_;
+  /// the response frames.
+  std::string *responses_;
+};
+
+/**
+ * @brief The exit command.
+ *
+ * Nothing runs on the thread pool, as exiting there would
+ * destroy the files under the main thread. Once the jobs
+ * before it are done, the Promise resolves, and the process
+ * exits on the main thread right after, like
+ * process.exit(). The jobs after it never start.
+ */
+class ExitJob : public Job {
+ public:
+  explicit ExitJob (Napi::Env env) : Job(env, false) {}
+
+ protected:
+  auto Execute () -> void override {}
+  auto OnOK () -> void override;
+  auto result_ () -> Napi::Value override;
+};
+
+/// the execBatch export, see BatchJob.
+auto execBatch (const Napi::CallbackInfo &info) -> Napi::Value;
+
+/**
+ * @brief Orders the jobs on the main thread.
+ *
+ * A write runs alone, after all the jobs submitted before
+ * it are done, while the queries submitted one after
+ * another run together. A job counts as running until its
+ * result is converted to JS on the main thread, as the
+ * conversion may read the data too.
+ */
+class JobQueue {
+ public:
+  /// queues the job, and gets its Promise.
+  static auto submit (Job *job) -> Napi::Promise;
+  /// marks a job as done, and starts the ones it held up.
+  static auto finish (const Job *job) -> void;
+
+ private:
+  /// the jobs not started yet, from head_ on.
+  static Vector<Job *> pending_;
+  static size_t head_;
+  static int reads_;
+  static bool writing_;
+
+  /// starts the jobs which may run now.
+  static auto pump_ () -> void;
+};
+
+} // namespace ticket::node
+
+#endif // TICKET_NODE_QUEUE_H_
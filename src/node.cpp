@@ -6,10 +6,8 @@
 
 #include <napi.h>
 
-#include "exception.h"
+#include "node-queue.h"
 #include "parser.h"
-#include "response.h"
-#include "result.h"
 #include "vector.h"
 
 namespace ticket::command {
@@ -18,228 +16,448 @@ inline auto isNullish (Napi::Value value) -> bool {
   return value.IsNull() || value.IsUndefined();
 }
 
-template <typename Cmd>
-inline auto handleCommand (Napi::Env env, const Cmd &cmd)
-  -> Napi::Value {
-  try {
-    auto resp = run(cmd);
-    if (auto err = resp.error()) {
-      auto error = Napi::Error::New(env, err->what());
-      error.ThrowAsJavaScriptException();
-      return {};
-    }
-    Napi::Value res;
-    resp.result().visit([&env, &res] (const auto &resp) {
-      res = response::toJsObject(env, resp);
-    });
-
-    return res;
-  } catch (const Exception &e) {
-    auto error = Napi::Error::New(env, e.what());
-    error.ThrowAsJavaScriptException();
-    return {};
-  }
+/**
+ * @brief reads the arguments, and queues the command.
+ *
+ * @return a Promise of the response.
+ */
+template <typename Args>
+inline auto submit (const Napi::CallbackInfo &info) -> Napi::Value {
+  auto *job = new node::CommandJob<Args>(info.Env());
+  job->args.read(info);
+  return node::JobQueue::submit(job);
 }
 
 #define CPP_STR(x) ((x).As<Napi::String>().Utf8Value())
 #define CPP_INT(x) ((x).As<Napi::Number>().Int32Value())
 #define CPP_BOOL(x) ((x).As<Napi::Boolean>().Value())
 
+struct NodeAddUser {
+  static constexpr bool readOnly = false;
+  AddUser cmd;
+  std::string currentUserStr;
+  std::string usernameStr;
+  std::string passwordStr;
+  std::string nameStr;
+  std::string emailStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    cmd.username = usernameStr = CPP_STR(args.Get("username"));
+    cmd.password = passwordStr = CPP_STR(args.Get("password"));
+    cmd.name = nameStr = CPP_STR(args.Get("name"));
+    cmd.email = emailStr = CPP_STR(args.Get("email"));
+    cmd.privilege = CPP_INT(args.Get("privilege"));
+  }
+};
+
 auto nodeAddUser (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  AddUser cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  cmd.username = CPP_STR(args.Get("username"));
-  cmd.password = CPP_STR(args.Get("password"));
-  cmd.name = CPP_STR(args.Get("name"));
-  cmd.email = CPP_STR(args.Get("email"));
-  cmd.privilege = CPP_INT(args.Get("privilege"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeAddUser>(info);
 }
 
+struct NodeLogin {
+  static constexpr bool readOnly = false;
+  Login cmd;
+  std::string usernameStr;
+  std::string passwordStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.username = usernameStr = CPP_STR(args.Get("username"));
+    cmd.password = passwordStr = CPP_STR(args.Get("password"));
+  }
+};
+
 auto nodeLogin (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  Login cmd;
-  auto args = info[0].ToObject();
-  cmd.username = CPP_STR(args.Get("username"));
-  cmd.password = CPP_STR(args.Get("password"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeLogin>(info);
 }
 
+struct NodeLogout {
+  static constexpr bool readOnly = false;
+  Logout cmd;
+  std::string usernameStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.username = usernameStr = CPP_STR(args.Get("username"));
+  }
+};
+
 auto nodeLogout (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  Logout cmd;
-  auto args = info[0].ToObject();
-  cmd.username = CPP_STR(args.Get("username"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeLogout>(info);
 }
 
+struct NodeQueryProfile {
+  static constexpr bool readOnly = true;
+  QueryProfile cmd;
+  std::string currentUserStr;
+  std::string usernameStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    cmd.username = usernameStr = CPP_STR(args.Get("username"));
+  }
+};
+
 auto nodeQueryProfile (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  QueryProfile cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  cmd.username = CPP_STR(args.Get("username"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeQueryProfile>(info);
 }
 
+struct NodeModifyProfile {
+  static constexpr bool readOnly = false;
+  ModifyProfile cmd;
+  std::string currentUserStr;
+  std::string usernameStr;
+  std::string passwordStr;
+  std::string nameStr;
+  std::string emailStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    cmd.username = usernameStr = CPP_STR(args.Get("username"));
+    if (!isNullish(args.Get("password"))) cmd.password = passwordStr = CPP_STR(args.Get("password"));
+    if (!isNullish(args.Get("name"))) cmd.name = nameStr = CPP_STR(args.Get("name"));
+    if (!isNullish(args.Get("email"))) cmd.email = emailStr = CPP_STR(args.Get("email"));
+    if (!isNullish(args.Get("privilege"))) cmd.privilege = CPP_INT(args.Get("privilege"));
+  }
+};
+
 auto nodeModifyProfile (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  ModifyProfile cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  cmd.username = CPP_STR(args.Get("username"));
-  if (!isNullish(args.Get("password"))) cmd.password = CPP_STR(args.Get("password"));
-  if (!isNullish(args.Get("name"))) cmd.name = CPP_STR(args.Get("name"));
-  if (!isNullish(args.Get("email"))) cmd.email = CPP_STR(args.Get("email"));
-  if (!isNullish(args.Get("privilege"))) cmd.privilege = CPP_INT(args.Get("privilege"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeModifyProfile>(info);
 }
 
-auto nodeAddTrain (const Napi::CallbackInfo &info)
-  -> Napi::Value {
+struct NodeAddTrain {
+  static constexpr bool readOnly = false;
   AddTrain cmd;
-  auto args = info[0].ToObject();
-  cmd.id = CPP_STR(args.Get("id"));
-  cmd.stops = CPP_INT(args.Get("stops"));
-  cmd.seats = CPP_INT(args.Get("seats"));
-  {
-    auto array = args.Get("stations").As<Napi::Array>();
-    cmd.stations.reserve(array.Length());
-    for (int i = 0; i < array.Length(); ++i) {
-      cmd.stations.push_back(CPP_STR(array.Get(i)));
+  std::string idStr;
+  Vector<std::string> stationsStrs;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.id = idStr = CPP_STR(args.Get("id"));
+    cmd.stops = CPP_INT(args.Get("stops"));
+    cmd.seats = CPP_INT(args.Get("seats"));
+    {
+      auto array = args.Get("stations").As<Napi::Array>();
+      cmd.stations.reserve(array.Length());
+      // reserved, so that the strings never move.
+      stationsStrs.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        stationsStrs.push_back(CPP_STR(array.Get(i)));
+        cmd.stations.push_back(stationsStrs.back());
+      }
     }
-  }
-  {
-    auto array = args.Get("prices").As<Napi::Array>();
-    cmd.prices.reserve(array.Length());
-    for (int i = 0; i < array.Length(); ++i) {
-      cmd.prices.push_back(CPP_INT(array.Get(i)));
+    {
+      auto array = args.Get("prices").As<Napi::Array>();
+      cmd.prices.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.prices.push_back(CPP_INT(array.Get(i)));
+      }
     }
-  }
-  cmd.departure = Instant(CPP_STR(args.Get("departure")).data());
-  {
-    auto array = args.Get("durations").As<Napi::Array>();
-    cmd.durations.reserve(array.Length());
-    for (int i = 0; i < array.Length(); ++i) {
-      cmd.durations.push_back(Duration(CPP_INT(array.Get(i))));
+    cmd.departure = Instant(CPP_STR(args.Get("departure")).data());
+    {
+      auto array = args.Get("durations").As<Napi::Array>();
+      cmd.durations.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.durations.push_back(Duration(CPP_INT(array.Get(i))));
+      }
     }
-  }
-  {
-    auto array = args.Get("stopoverTimes").As<Napi::Array>();
-    cmd.stopoverTimes.reserve(array.Length());
-    for (int i = 0; i < array.Length(); ++i) {
-      cmd.stopoverTimes.push_back(Duration(CPP_INT(array.Get(i))));
+    {
+      auto array = args.Get("stopoverTimes").As<Napi::Array>();
+      cmd.stopoverTimes.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.stopoverTimes.push_back(Duration(CPP_INT(array.Get(i))));
+      }
     }
-  }
-  {
-    auto array = args.Get("dates").As<Napi::Array>();
-    cmd.dates.reserve(array.Length());
-    for (int i = 0; i < array.Length(); ++i) {
-      cmd.dates.push_back(Date(CPP_STR(array.Get(i)).data()));
+    {
+      auto array = args.Get("dates").As<Napi::Array>();
+      cmd.dates.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.dates.push_back(Date(CPP_STR(array.Get(i)).data()));
+      }
     }
+    cmd.type = CPP_STR(args.Get("type"))[0];
   }
-  cmd.type = CPP_STR(args.Get("type"))[0];
-  return handleCommand(info.Env(), cmd);
+};
+
+auto nodeAddTrain (const Napi::CallbackInfo &info)
+  -> Napi::Value {
+  return submit<NodeAddTrain>(info);
 }
 
+struct NodeDeleteTrain {
+  static constexpr bool readOnly = false;
+  DeleteTrain cmd;
+  std::string idStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.id = idStr = CPP_STR(args.Get("id"));
+  }
+};
+
 auto nodeDeleteTrain (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  DeleteTrain cmd;
-  auto args = info[0].ToObject();
-  cmd.id = CPP_STR(args.Get("id"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeDeleteTrain>(info);
 }
 
+struct NodeReleaseTrain {
+  static constexpr bool readOnly = false;
+  ReleaseTrain cmd;
+  std::string idStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.id = idStr = CPP_STR(args.Get("id"));
+  }
+};
+
 auto nodeReleaseTrain (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  ReleaseTrain cmd;
-  auto args = info[0].ToObject();
-  cmd.id = CPP_STR(args.Get("id"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeReleaseTrain>(info);
 }
 
+struct NodeQueryTrain {
+  static constexpr bool readOnly = true;
+  QueryTrain cmd;
+  std::string idStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.id = idStr = CPP_STR(args.Get("id"));
+    cmd.date = Date(CPP_STR(args.Get("date")).data());
+  }
+};
+
 auto nodeQueryTrain (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  QueryTrain cmd;
-  auto args = info[0].ToObject();
-  cmd.id = CPP_STR(args.Get("id"));
-  cmd.date = Date(CPP_STR(args.Get("date")).data());
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeQueryTrain>(info);
 }
 
+struct NodeQueryTicket {
+  static constexpr bool readOnly = true;
+  QueryTicket cmd;
+  std::string fromStr;
+  std::string toStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.from = fromStr = CPP_STR(args.Get("from"));
+    cmd.to = toStr = CPP_STR(args.Get("to"));
+    cmd.date = Date(CPP_STR(args.Get("date")).data());
+    if (!isNullish(args.Get("sort"))) cmd.sort = CPP_STR(args.Get("sort"))[0] == 't' ? kTime : kCost;
+    if (!isNullish(args.Get("limit"))) cmd.limit = CPP_INT(args.Get("limit"));
+    if (!isNullish(args.Get("offset"))) cmd.offset = CPP_INT(args.Get("offset"));
+  }
+};
+
 auto nodeQueryTicket (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  QueryTicket cmd;
-  auto args = info[0].ToObject();
-  cmd.from = CPP_STR(args.Get("from"));
-  cmd.to = CPP_STR(args.Get("to"));
-  cmd.date = Date(CPP_STR(args.Get("date")).data());
-  if (!isNullish(args.Get("sort"))) cmd.sort = CPP_STR(args.Get("sort"))[0] == 't' ? kTime : kCost;
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeQueryTicket>(info);
 }
 
+struct NodeQueryTransfer {
+  static constexpr bool readOnly = true;
+  QueryTransfer cmd;
+  std::string fromStr;
+  std::string toStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.from = fromStr = CPP_STR(args.Get("from"));
+    cmd.to = toStr = CPP_STR(args.Get("to"));
+    cmd.date = Date(CPP_STR(args.Get("date")).data());
+    if (!isNullish(args.Get("sort"))) cmd.sort = CPP_STR(args.Get("sort"))[0] == 't' ? kTime : kCost;
+  }
+};
+
 auto nodeQueryTransfer (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  QueryTransfer cmd;
-  auto args = info[0].ToObject();
-  cmd.from = CPP_STR(args.Get("from"));
-  cmd.to = CPP_STR(args.Get("to"));
-  cmd.date = Date(CPP_STR(args.Get("date")).data());
-  if (!isNullish(args.Get("sort"))) cmd.sort = CPP_STR(args.Get("sort"))[0] == 't' ? kTime : kCost;
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeQueryTransfer>(info);
 }
 
-auto nodeBuyTicket (const Napi::CallbackInfo &info)
+struct NodeQueryJourney {
+  static constexpr bool readOnly = true;
+  QueryJourney cmd;
+  std::string fromStr;
+  std::string toStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.from = fromStr = CPP_STR(args.Get("from"));
+    cmd.to = toStr = CPP_STR(args.Get("to"));
+    cmd.date = Date(CPP_STR(args.Get("date")).data());
+    if (!isNullish(args.Get("sort"))) cmd.sort = CPP_STR(args.Get("sort"))[0] == 't' ? kTime : kCost;
+    if (!isNullish(args.Get("transfers"))) cmd.transfers = CPP_INT(args.Get("transfers"));
+  }
+};
+
+auto nodeQueryJourney (const Napi::CallbackInfo &info)
   -> Napi::Value {
+  return submit<NodeQueryJourney>(info);
+}
+
+struct NodeBuyTicket {
+  static constexpr bool readOnly = false;
   BuyTicket cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  cmd.train = CPP_STR(args.Get("train"));
-  cmd.date = Date(CPP_STR(args.Get("date")).data());
-  cmd.seats = CPP_INT(args.Get("seats"));
-  cmd.from = CPP_STR(args.Get("from"));
-  cmd.to = CPP_STR(args.Get("to"));
-  if (!isNullish(args.Get("queue"))) cmd.queue = CPP_BOOL(args.Get("queue"));
-  return handleCommand(info.Env(), cmd);
+  std::string currentUserStr;
+  std::string trainStr;
+  std::string fromStr;
+  std::string toStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    cmd.train = trainStr = CPP_STR(args.Get("train"));
+    cmd.date = Date(CPP_STR(args.Get("date")).data());
+    cmd.seats = CPP_INT(args.Get("seats"));
+    cmd.from = fromStr = CPP_STR(args.Get("from"));
+    cmd.to = toStr = CPP_STR(args.Get("to"));
+    if (!isNullish(args.Get("queue"))) cmd.queue = CPP_BOOL(args.Get("queue"));
+  }
+};
+
+auto nodeBuyTicket (const Napi::CallbackInfo &info)
+  -> Napi::Value {
+  return submit<NodeBuyTicket>(info);
 }
 
-auto nodeQueryOrder (const Napi::CallbackInfo &info)
+struct NodeBuyTickets {
+  static constexpr bool readOnly = false;
+  BuyTickets cmd;
+  std::string currentUserStr;
+  Vector<std::string> trainsStrs;
+  Vector<std::string> fromStrs;
+  Vector<std::string> toStrs;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    {
+      auto array = args.Get("trains").As<Napi::Array>();
+      cmd.trains.reserve(array.Length());
+      // reserved, so that the strings never move.
+      trainsStrs.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        trainsStrs.push_back(CPP_STR(array.Get(i)));
+        cmd.trains.push_back(trainsStrs.back());
+      }
+    }
+    {
+      auto array = args.Get("dates").As<Napi::Array>();
+      cmd.dates.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.dates.push_back(Date(CPP_STR(array.Get(i)).data()));
+      }
+    }
+    {
+      auto array = args.Get("seats").As<Napi::Array>();
+      cmd.seats.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        cmd.seats.push_back(CPP_INT(array.Get(i)));
+      }
+    }
+    {
+      auto array = args.Get("from").As<Napi::Array>();
+      cmd.from.reserve(array.Length());
+      // reserved, so that the strings never move.
+      fromStrs.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        fromStrs.push_back(CPP_STR(array.Get(i)));
+        cmd.from.push_back(fromStrs.back());
+      }
+    }
+    {
+      auto array = args.Get("to").As<Napi::Array>();
+      cmd.to.reserve(array.Length());
+      // reserved, so that the strings never move.
+      toStrs.reserve(array.Length());
+      for (int i = 0; i < array.Length(); ++i) {
+        toStrs.push_back(CPP_STR(array.Get(i)));
+        cmd.to.push_back(toStrs.back());
+      }
+    }
+  }
+};
+
+auto nodeBuyTickets (const Napi::CallbackInfo &info)
   -> Napi::Value {
+  return submit<NodeBuyTickets>(info);
+}
+
+struct NodeQueryOrder {
+  static constexpr bool readOnly = true;
   QueryOrder cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  return handleCommand(info.Env(), cmd);
+  std::string currentUserStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    if (!isNullish(args.Get("limit"))) cmd.limit = CPP_INT(args.Get("limit"));
+    if (!isNullish(args.Get("offset"))) cmd.offset = CPP_INT(args.Get("offset"));
+  }
+};
+
+auto nodeQueryOrder (const Napi::CallbackInfo &info)
+  -> Napi::Value {
+  return submit<NodeQueryOrder>(info);
 }
 
+struct NodeRefundTicket {
+  static constexpr bool readOnly = false;
+  RefundTicket cmd;
+  std::string currentUserStr;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.currentUser = currentUserStr = CPP_STR(args.Get("currentUser"));
+    if (!isNullish(args.Get("index"))) cmd.index = CPP_INT(args.Get("index"));
+  }
+};
+
 auto nodeRefundTicket (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  RefundTicket cmd;
-  auto args = info[0].ToObject();
-  cmd.currentUser = CPP_STR(args.Get("currentUser"));
-  if (!isNullish(args.Get("index"))) cmd.index = CPP_INT(args.Get("index"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeRefundTicket>(info);
 }
 
+struct NodeRollback {
+  static constexpr bool readOnly = false;
+  Rollback cmd;
+
+  auto read (const Napi::CallbackInfo &info) -> void {
+    auto args = info[0].ToObject();
+    cmd.timestamp = CPP_INT(args.Get("timestamp"));
+  }
+};
+
 auto nodeRollback (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  Rollback cmd;
-  auto args = info[0].ToObject();
-  cmd.timestamp = CPP_INT(args.Get("timestamp"));
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeRollback>(info);
 }
 
+struct NodeClean {
+  static constexpr bool readOnly = false;
+  Clean cmd;
+
+  auto read (const Napi::CallbackInfo & /* unused */) -> void {}
+};
+
 auto nodeClean (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  Clean cmd;
-  return handleCommand(info.Env(), cmd);
+  return submit<NodeClean>(info);
 }
 
 auto nodeExit (const Napi::CallbackInfo &info)
   -> Napi::Value {
-  Exit cmd;
-  return handleCommand(info.Env(), cmd);
+  return node::JobQueue::submit(new node::ExitJob(info.Env()));
 }
 
 #undef CPP_STR
@@ -259,12 +477,15 @@ auto init (Napi::Env env, Napi::Object exports)
   exports["queryTrain"] = Napi::Function::New(env, nodeQueryTrain);
   exports["queryTicket"] = Napi::Function::New(env, nodeQueryTicket);
   exports["queryTransfer"] = Napi::Function::New(env, nodeQueryTransfer);
+  exports["queryJourney"] = Napi::Function::New(env, nodeQueryJourney);
   exports["buyTicket"] = Napi::Function::New(env, nodeBuyTicket);
+  exports["buyTickets"] = Napi::Function::New(env, nodeBuyTickets);
   exports["queryOrder"] = Napi::Function::New(env, nodeQueryOrder);
   exports["refundTicket"] = Napi::Function::New(env, nodeRefundTicket);
   exports["rollback"] = Napi::Function::New(env, nodeRollback);
   exports["clean"] = Napi::Function::New(env, nodeClean);
   exports["exit"] = Napi::Function::New(env, nodeExit);
+  exports["execBatch"] = Napi::Function::New(env, node::execBatch);
   return exports;
 }
 
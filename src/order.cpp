@@ -1,6 +1,9 @@
 #include "order.h"
 
+#include <climits>
+
 #include "algorithm.h"
+#include "hashmap.h"
 #include "parser.h"
 #include "rollback.h"
 #include "run.h"
@@ -8,18 +11,49 @@
 
 namespace ticket {
 
-file::Index<User::Id, Order> Order::ixUserId
+file::Index<User::Id, Order, Greater<>> Order::ixUserId
   {&Order::user, "orders.user.ix"};
 
-file::Index<Ride, Order> Order::pendingOrders {
-  &Order::ride,
-  "orders-pending.ride.ix"
-};
+PendingQueue Order::pendingOrders {"orders-pending.ride.ix"};
+
+auto PendingQueue::insert (const Order &order) -> void {
+  tree_.insert(order.ride, order.pendingEntry());
+}
+auto PendingQueue::remove (const Order &order) -> void {
+  tree_.remove(order.ride, order.pendingEntry());
+}
 
 auto OrderBase::getSubTotal () const -> long long {
   return static_cast<long long>(price) * seats;
 }
 
+namespace {
+
+/// builds an order of the given trip, without saving it.
+auto makeOrder (
+  const Train &train, const Ride &ride, int ixFrom, int ixTo,
+  int seats, std::string_view user,
+  std::string_view from, std::string_view to
+) -> Order {
+  Order order;
+  order.user = user;
+  order.ride = ride;
+  order.ixFrom = ixFrom;
+  order.ixTo = ixTo;
+  order.price = train.totalPrice(ixFrom, ixTo);
+  order.seats = seats;
+
+  auto &cache = order.cache;
+  cache.trainId = train.trainId;
+  cache.timeArrival = train.edges[ixTo - 1].arrival;
+  cache.timeDeparture = train.edges[ixFrom].departure;
+  cache.from = from;
+  cache.to = to;
+  return order;
+}
+
+} // namespace
+
 auto command::run (const command::BuyTicket &cmd)
   -> Result<Response, Exception> {
   if (!User::isLoggedIn(cmd.currentUser)) {
@@ -46,20 +80,10 @@ auto command::run (const command::BuyTicket &cmd)
     return Exception("no such train on this date");
   }
 
-  Order order;
-  order.user = cmd.currentUser;
-  order.ride = seatsInfo->ride;
-  order.ixFrom = *ixFrom;
-  order.ixTo = *ixTo;
-  order.price = train->totalPrice(*ixFrom, *ixTo);
-  order.seats = cmd.seats;
-
-  auto &cache = order.cache;
-  cache.trainId = train->trainId;
-  cache.timeArrival = train->edges[*ixTo - 1].arrival;
-  cache.timeDeparture = train->edges[*ixFrom].departure;
-  cache.from = cmd.from;
-  cache.to = cmd.to;
+  auto order = makeOrder(
+    *train, seatsInfo->ride, *ixFrom, *ixTo, cmd.seats,
+    cmd.currentUser, cmd.from, cmd.to
+  );
 
   if (seatsInfo->ticketsAvailable(*ixFrom, *ixTo) < cmd.seats) {
     if (!cmd.queue) return Exception("not enough tickets");
@@ -85,15 +109,96 @@ auto command::run (const command::BuyTicket &cmd)
   });
 }
 
+auto command::run (const command::BuyTickets &cmd)
+  -> Result<Response, Exception> {
+  if (!User::isLoggedIn(cmd.currentUser)) {
+    return Exception("not logged in");
+  }
+  const int legs = cmd.trains.size();
+  if (legs == 0 || cmd.dates.size() != legs ||
+      cmd.seats.size() != legs || cmd.from.size() != legs ||
+      cmd.to.size() != legs) {
+    return Exception("malformed legs");
+  }
+
+  // every train and every ride is looked up only once, and
+  // nothing is written until all legs are known to succeed.
+  HashMap<std::string_view, Train> trains;
+  HashMap<int, int> ixRides;
+  Vector<RideSeats> rides;
+  Vector<Order> orders;
+  orders.reserve(legs);
+  long long total = 0;
+  for (int i = 0; i < legs; ++i) {
+    auto itTrain = trains.find(cmd.trains[i]);
+    if (itTrain == trains.end()) {
+      auto train = Train::ixId.findOne(cmd.trains[i]);
+      if (!train || train->deleted) {
+        return Exception("no such train");
+      }
+      itTrain = trains.insert({ cmd.trains[i], *train }).first;
+    }
+    const auto &train = itTrain->second;
+    if (cmd.seats[i] > train.seats) {
+      return Exception("too many seats for this train");
+    }
+
+    auto ixFrom = train.indexOfStop(cmd.from[i]);
+    auto ixTo = train.indexOfStop(cmd.to[i]);
+    if (!ixFrom || !ixTo) return Exception("no such station");
+    if (*ixFrom >= *ixTo) {
+      return Exception("the train runs in the opposite way");
+    }
+
+    Ride ride {
+      train.id(),
+      cmd.dates[i] - train.edges[*ixFrom].departure.daysOverflow()
+    };
+    auto ixRideId = RideSeats::ixRide.findOneId(ride);
+    if (!ixRideId) return Exception("no such train on this date");
+    auto itRide = ixRides.find(*ixRideId);
+    if (itRide == ixRides.end()) {
+      itRide = ixRides.insert({ *ixRideId, (int) rides.size() }).first;
+      rides.push_back(RideSeats::get(*ixRideId));
+    }
+    auto &seats = rides[itRide->second];
+
+    if (seats.ticketsAvailable(*ixFrom, *ixTo) < cmd.seats[i]) {
+      return Exception("not enough tickets");
+    }
+    seats.rangeAdd(-cmd.seats[i], *ixFrom, *ixTo);
+
+    auto order = makeOrder(
+      train, ride, *ixFrom, *ixTo, cmd.seats[i],
+      cmd.currentUser, cmd.from[i], cmd.to[i]
+    );
+    order.status = Order::kSuccess;
+    total += order.getSubTotal();
+    orders.push_back(order);
+  }
+
+  for (auto &seats : rides) seats.update();
+  for (auto &order : orders) {
+    order.save();
+    Order::ixUserId.insert(order);
+    rollback::log(rollback::BuyTicket{(int) order.id()});
+  }
+
+  return BuyTicketResponse(BuyTicketSuccess{total});
+}
+
 auto command::run (const command::QueryOrder &cmd)
   -> Result<Response, Exception> {
   if (!User::isLoggedIn(cmd.currentUser)) {
     return Exception("not logged in");
   }
 
-  auto orderIds =
-    Order::ixUserId.findManyId(cmd.currentUser);
-  sort(orderIds.begin(), orderIds.end(), Greater<>());
+  // the index is already newest first, so a page is a
+  // single scan of the leaves.
+  int offset = std::max(cmd.offset, 0);
+  auto orderIds = cmd.limit
+    ? Order::ixUserId.findManyId(cmd.currentUser, offset, *cmd.limit)
+    : Order::ixUserId.findManyId(cmd.currentUser, offset, INT_MAX);
 
   // not orderIds.map(Order::get) here because a wrap object
   // is needed for Variant
@@ -108,13 +213,11 @@ auto command::run (const command::RefundTicket &cmd)
     return Exception("not logged in");
   }
 
-  auto orderIds =
-    Order::ixUserId.findManyId(cmd.currentUser);
-  sort(orderIds.begin(), orderIds.end(), Greater<>());
-  if (cmd.index > orderIds.size()) {
-    return Exception("no such order");
-  }
-  auto order = Order::get(orderIds[cmd.index - 1]);
+  if (cmd.index < 1) return Exception("no such order");
+  auto orderIds = Order::ixUserId.findManyId(
+    cmd.currentUser, cmd.index - 1, 1);
+  if (orderIds.empty()) return Exception("no such order");
+  auto order = Order::get(orderIds[0]);
   if (order.status == Order::kRefunded) {
     return Exception("the order has already been refunded");
   }
@@ -139,28 +242,31 @@ auto command::run (const command::RefundTicket &cmd)
   auto seats = RideSeats::ixRide.findOne(order.ride);
   seats->rangeAdd(order.seats, order.ixFrom, order.ixTo);
 
-  // ok, let's check for other pending orders.
+  // ok, let's check for other pending orders. every pending
+  // order was unsatisfiable before this refund, and only the
+  // segments [order.ixFrom, order.ixTo) gained seats, so an
+  // entry can only be fulfilled now if it overlaps them and
+  // asks for no more than their maximum.
+  int cap = 0;
+  for (int i = order.ixFrom; i < order.ixTo; ++i) {
+    cap = std::max(cap, seats->seatsRemaining[i]);
+  }
   auto pending = Order::pendingOrders.findMany(order.ride);
-  // sort(pending.begin(), pending.end(), Cmp(
-  //   [] (const Order &lhs, const Order &rhs) {
-  //     return lhs.id() < rhs.id();
-  //   }
-  // ));
-  // TODO(perf): speed up the for loop (RMQ?)
-  for (auto &target : pending) {
+  for (const auto &entry : pending) {
+    if (entry.seats > cap) continue;
+    if (entry.ixTo <= order.ixFrom || entry.ixFrom >= order.ixTo) {
+      continue;
+    }
     auto max =
-      seats->ticketsAvailable(target.ixFrom, target.ixTo);
-    if (max < target.seats) continue;
+      seats->ticketsAvailable(entry.ixFrom, entry.ixTo);
+    if (max < entry.seats) continue;
 
-    seats->rangeAdd(
-      -target.seats,
-      target.ixFrom,
-      target.ixTo
-    );
+    seats->rangeAdd(-entry.seats, entry.ixFrom, entry.ixTo);
 
+    auto target = Order::get(entry.id);
     target.status = Order::kSuccess;
     target.update();
-    Order::pendingOrders.remove(target);
+    Order::pendingOrders.remove(order.ride, entry);
 
     rollback::log(rollback::FulfillOrder{target.id()});
   }
@@ -169,52 +275,151 @@ auto command::run (const command::RefundTicket &cmd)
   return unit;
 }
 
-auto rollback::run (const rollback::BuyTicket &log)
-  -> Result<Unit, Exception> {
-  auto order = Order::get(log.id);
+namespace {
+
+/// packs a ride into a key. dates are within 92 days.
+auto rideKey (const Ride &ride) -> long long {
+  return (long long) ride.train << 8 | (ride.date - Date(6, 1));
+}
+
+} // namespace
+
+auto rollback::OrderUndo::order (int id) -> const Order & {
+  auto it = orders_.find(id);
+  if (it == orders_.end()) {
+    it = orders_.insert({ id, { Order::get(id) } }).first;
+  }
+  return it->second.order;
+}
+auto rollback::OrderUndo::setStatus (int id, Order::Status status)
+  -> void {
+  order(id);
+  auto &cached = orders_.find(id)->second;
+  cached.order.status = status;
+  cached.dirty = true;
+}
+auto rollback::OrderUndo::seats (const Ride &ride) -> RideSeats & {
+  auto key = rideKey(ride);
+  auto it = rides_.find(key);
+  if (it == rides_.end()) {
+    // deref it here as the ride of an order always exists.
+    it = rides_.insert({ key, *RideSeats::ixRide.findOne(ride) }).first;
+  }
+  return it->second;
+}
+auto rollback::OrderUndo::enqueue (const Order &order) -> void {
+  ++pending_[order.id()];
+}
+auto rollback::OrderUndo::dequeue (const Order &order) -> void {
+  --pending_[order.id()];
+}
+auto rollback::OrderUndo::removeFromUser (const Order &order)
+  -> void {
+  removedFromUser_.push_back(order.id());
+}
+
+auto rollback::OrderUndo::flush () -> void {
+  // the index entries are changed in the order of their
+  // keys, so that neighbouring changes hit the same leaves.
+  sort(removedFromUser_.begin(), removedFromUser_.end(),
+    Cmp([this] (int lhs, int rhs) {
+      auto hl = order(lhs).user.hash(), hr = order(rhs).user.hash();
+      if (hl != hr) return hl < hr;
+      return lhs > rhs;
+    }));
+  for (auto id : removedFromUser_) {
+    Order::ixUserId.remove(order(id));
+  }
+
+  // an order enqueued and then dequeued again, or the other
+  // way around, is left as it is.
+  Vector<int> queued;
+  for (const auto &entry : pending_) {
+    TICKET_ASSERT(entry.second >= -1 && entry.second <= 1);
+    if (entry.second != 0) queued.push_back(entry.first);
+  }
+  sort(queued.begin(), queued.end(),
+    Cmp([this] (int lhs, int rhs) {
+      // copies, as order() may move the cached orders.
+      auto rl = order(lhs).ride, rr = order(rhs).ride;
+      if (rl < rr) return true;
+      if (rr < rl) return false;
+      return lhs < rhs;
+    }));
+  for (auto id : queued) {
+    if (pending_[id] > 0) {
+      Order::pendingOrders.insert(order(id));
+    } else {
+      Order::pendingOrders.remove(order(id));
+    }
+  }
+
+  Vector<RideSeats *> rides;
+  for (auto &entry : rides_) rides.push_back(&entry.second);
+  sort(rides.begin(), rides.end(),
+    Cmp([] (const RideSeats *lhs, const RideSeats *rhs) {
+      return lhs->id() < rhs->id();
+    }));
+  for (auto seats : rides) seats->update();
+
+  Vector<Order *> orders;
+  for (auto &entry : orders_) {
+    if (entry.second.dirty) orders.push_back(&entry.second.order);
+  }
+  sort(orders.begin(), orders.end(),
+    Cmp([] (const Order *lhs, const Order *rhs) {
+      return lhs->id() < rhs->id();
+    }));
+  for (auto order : orders) order->update();
+
+  orders_.clear();
+  rides_.clear();
+  pending_.clear();
+  removedFromUser_.clear();
+}
+
+auto rollback::run (
+  const rollback::BuyTicket &log, rollback::OrderUndo &undo
+) -> Result<Unit, Exception> {
+  const auto &order = undo.order(log.id);
   if (order.status == Order::kPending) {
-    Order::pendingOrders.remove(order);
+    undo.dequeue(order);
   } else {
-    auto ride = RideSeats::ixRide.findOne(order.ride);
-    ride->rangeAdd(order.seats, order.ixFrom, order.ixTo);
-    ride->update();
+    undo.seats(order.ride)
+      .rangeAdd(order.seats, order.ixFrom, order.ixTo);
   }
-  Order::ixUserId.remove(order);
+  undo.removeFromUser(order);
   // order.destroy();
   return unit;
 }
 
-auto rollback::run (const rollback::RefundTicket &log)
-  -> Result<Unit, Exception> {
+auto rollback::run (
+  const rollback::RefundTicket &log, rollback::OrderUndo &undo
+) -> Result<Unit, Exception> {
   // we only need to undo the refund operation. Fulfilled
   // orders will be undone in its own function.
-  auto order = Order::get(log.id);
-  TICKET_ASSERT(order.status == Order::kRefunded);
-  order.status = log.status;
-  order.update();
+  TICKET_ASSERT(undo.order(log.id).status == Order::kRefunded);
+  undo.setStatus(log.id, log.status);
+  const auto &order = undo.order(log.id);
 
   if (order.status == Order::kSuccess) {
-    // deref it here as we are sure that it exists.
-    auto ride = *RideSeats::ixRide.findOne(order.ride);
-    ride.rangeAdd(-order.seats, order.ixFrom, order.ixTo);
-    ride.update();
+    undo.seats(order.ride)
+      .rangeAdd(-order.seats, order.ixFrom, order.ixTo);
   } else {
-    Order::pendingOrders.insert(order);
+    undo.enqueue(order);
   }
   return unit;
 }
 
-auto rollback::run (const rollback::FulfillOrder &log)
-  -> Result<Unit, Exception> {
-  auto order = Order::get(log.id);
-  TICKET_ASSERT(order.status == Order::kSuccess);
-  order.status = Order::kPending;
-  order.update();
-  Order::pendingOrders.insert(order);
-
-  auto ride = *RideSeats::ixRide.findOne(order.ride);
-  ride.rangeAdd(order.seats, order.ixFrom, order.ixTo);
-  ride.update();
+auto rollback::run (
+  const rollback::FulfillOrder &log, rollback::OrderUndo &undo
+) -> Result<Unit, Exception> {
+  TICKET_ASSERT(undo.order(log.id).status == Order::kSuccess);
+  undo.setStatus(log.id, Order::kPending);
+  const auto &order = undo.order(log.id);
+  undo.enqueue(order);
+  undo.seats(order.ride)
+    .rangeAdd(order.seats, order.ixFrom, order.ixTo);
   return unit;
 }
 
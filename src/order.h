@@ -44,12 +44,61 @@ struct OrderBase {
 
   static constexpr const char *filename = "orders";
 };
+
+/**
+ * @brief A compact entry of the pending queue.
+ *
+ * It holds everything needed to decide whether a pending
+ * order can be fulfilled, so that the order itself is only
+ * loaded when it is.
+ */
+struct PendingOrder {
+  int id;
+  int ixFrom, ixTo;
+  int seats;
+
+  /// entries are ordered by id, i.e. first come first serve.
+  auto operator< (const PendingOrder &rhs) const -> bool {
+    return id < rhs.id;
+  }
+};
+
+struct Order;
+/// The per-ride FIFO queues of pending orders.
+class PendingQueue {
+ public:
+  PendingQueue (const char *filename) : tree_(filename) {}
+  /// enqueues a pending order.
+  auto insert (const Order &order) -> void;
+  /// removes a pending order from its queue.
+  auto remove (const Order &order) -> void;
+  /// removes an entry from the queue of the given ride.
+  auto remove (const Ride &ride, const PendingOrder &entry)
+    -> void {
+    tree_.remove(ride, entry);
+  }
+  /// gets the queue of a ride, in FIFO order.
+  auto findMany (const Ride &ride) -> Vector<PendingOrder> {
+    return tree_.findMany(ride);
+  }
+
+  /// deletes all entries.
+  auto truncate () -> void { tree_.truncate(); }
+ private:
+  file::BpTree<Ride, PendingOrder> tree_;
+};
+
 struct Order : public file::Managed<OrderBase> {
   Order () = default;
   Order (const file::Managed<OrderBase> &order)
     : file::Managed<OrderBase>(order) {}
-  static file::Index<User::Id, Order> ixUserId;
-  static file::Index<Ride, Order> pendingOrders;
+  /// gets the pending queue entry of this order.
+  auto pendingEntry () const -> PendingOrder {
+    return { id(), ixFrom, ixTo, seats };
+  }
+  /// orders of each user, newest first.
+  static file::Index<User::Id, Order, Greater<>> ixUserId;
+  static PendingQueue pendingOrders;
 };
 
 /**
@@ -2,281 +2,975 @@
 
 #include "parser.h"
 
+#include "binary.h"
 #include "utility.h"
 
 namespace ticket::command {
 
-auto parse (std::string &str)
-  -> Result<Command, ParseException> {
-  auto argv = split(str, ' ');
-  return parse(argv);
-}
+namespace {
 
-auto parse (const Vector<std::string_view> &argv)
+auto parseAddUser (const Vector<std::string_view> &argv)
   -> Result<Command, ParseException> {
-  auto &argv0 = argv[0];
-  if (argv0 == "add_user") {
-    AddUser res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-c") {
-        res.currentUser = argv[++i].data();
-      } else if (arg == "-u") {
-        res.username = argv[++i].data();
-      } else if (arg == "-p") {
-        res.password = argv[++i].data();
-      } else if (arg == "-n") {
-        res.name = argv[++i].data();
-      } else if (arg == "-m") {
-        res.email = argv[++i].data();
-      } else if (arg == "-g") {
+  AddUser res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'c':
+        res.currentUser = argv[++i];
+        break;
+      case 'u':
+        res.username = argv[++i];
+        break;
+      case 'p':
+        res.password = argv[++i];
+        break;
+      case 'n':
+        res.name = argv[++i];
+        break;
+      case 'm':
+        res.email = argv[++i];
+        break;
+      case 'g':
         res.privilege = atoi(argv[++i].data());
-      } else {
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "login") {
-    Login res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-u") {
-        res.username = argv[++i].data();
-      } else if (arg == "-p") {
-        res.password = argv[++i].data();
-      } else {
+  }
+  return res;
+}
+
+auto parseLogin (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  Login res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'u':
+        res.username = argv[++i];
+        break;
+      case 'p':
+        res.password = argv[++i];
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "logout") {
-    Logout res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-u") {
-        res.username = argv[++i].data();
-      } else {
+  }
+  return res;
+}
+
+auto parseLogout (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  Logout res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'u':
+        res.username = argv[++i];
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "query_profile") {
-    QueryProfile res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-c") {
-        res.currentUser = argv[++i].data();
-      } else if (arg == "-u") {
-        res.username = argv[++i].data();
-      } else {
+  }
+  return res;
+}
+
+auto parseQueryProfile (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryProfile res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'c':
+        res.currentUser = argv[++i];
+        break;
+      case 'u':
+        res.username = argv[++i];
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "modify_profile") {
-    ModifyProfile res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-c") {
-        res.currentUser = argv[++i].data();
-      } else if (arg == "-u") {
-        res.username = argv[++i].data();
-      } else if (arg == "-p") {
-        res.password = argv[++i].data();
-      } else if (arg == "-n") {
-        res.name = argv[++i].data();
-      } else if (arg == "-m") {
-        res.email = argv[++i].data();
-      } else if (arg == "-g") {
+  }
+  return res;
+}
+
+auto parseModifyProfile (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  ModifyProfile res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'c':
+        res.currentUser = argv[++i];
+        break;
+      case 'u':
+        res.username = argv[++i];
+        break;
+      case 'p':
+        res.password = argv[++i];
+        break;
+      case 'n':
+        res.name = argv[++i];
+        break;
+      case 'm':
+        res.email = argv[++i];
+        break;
+      case 'g':
         res.privilege = atoi(argv[++i].data());
-      } else {
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "add_train") {
-    AddTrain res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-i") {
-        res.id = argv[++i].data();
-      } else if (arg == "-n") {
+  }
+  return res;
+}
+
+auto parseAddTrain (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  AddTrain res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'i':
+        res.id = argv[++i];
+        break;
+      case 'n':
         res.stops = atoi(argv[++i].data());
-      } else if (arg == "-m") {
+        break;
+      case 'm':
         res.seats = atoi(argv[++i].data());
-      } else if (arg == "-s") {
-        std::string val = argv[++i].data();
-        res.stations = copyStrings(split(val, '|'));
-      } else if (arg == "-p") {
-        std::string val = argv[++i].data();
-        auto values = split(val, '|');
+        break;
+      case 's': {
+        res.stations = splitView(argv[++i], '|');
+        break;
+      }
+      case 'p': {
+        auto values = splitView(argv[++i], '|');
         res.prices.reserve(values.size());
         for (auto &str : values) {
           res.prices.push_back(atoi(str.data()));
         }
-      } else if (arg == "-x") {
+        break;
+      }
+      case 'x':
         res.departure = Instant(argv[++i].data());
-      } else if (arg == "-t") {
-        std::string val = argv[++i].data();
-        auto values = split(val, '|');
+        break;
+      case 't': {
+        auto values = splitView(argv[++i], '|');
         res.durations.reserve(values.size());
         for (auto &str : values) {
           res.durations.push_back(Duration(atoi(str.data())));
         }
-      } else if (arg == "-o") {
-        std::string val = argv[++i].data();
-        auto values = split(val, '|');
+        break;
+      }
+      case 'o': {
+        auto values = splitView(argv[++i], '|');
         res.stopoverTimes.reserve(values.size());
         for (auto &str : values) {
           res.stopoverTimes.push_back(Duration(atoi(str.data())));
         }
-      } else if (arg == "-d") {
-        std::string val = argv[++i].data();
-        auto values = split(val, '|');
+        break;
+      }
+      case 'd': {
+        auto values = splitView(argv[++i], '|');
         res.dates.reserve(values.size());
         for (auto &str : values) {
           res.dates.push_back(Date(str.data()));
         }
-      } else if (arg == "-y") {
-        res.type = *argv[++i].data();
-      } else {
-        return ParseException();
+        break;
       }
+      case 'y':
+        res.type = argv[++i][0];
+        break;
+      default:
+        return ParseException();
     }
-    return res;
-  } else if (argv0 == "delete_train") {
-    DeleteTrain res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-i") {
-        res.id = argv[++i].data();
-      } else {
+  }
+  return res;
+}
+
+auto parseDeleteTrain (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  DeleteTrain res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'i':
+        res.id = argv[++i];
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "release_train") {
-    ReleaseTrain res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-i") {
-        res.id = argv[++i].data();
-      } else {
+  }
+  return res;
+}
+
+auto parseReleaseTrain (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  ReleaseTrain res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'i':
+        res.id = argv[++i];
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "query_train") {
-    QueryTrain res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-i") {
-        res.id = argv[++i].data();
-      } else if (arg == "-d") {
+  }
+  return res;
+}
+
+auto parseQueryTrain (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryTrain res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'i':
+        res.id = argv[++i];
+        break;
+      case 'd':
         res.date = Date(argv[++i].data());
-      } else {
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "query_ticket") {
-    QueryTicket res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-s") {
-        res.from = argv[++i].data();
-      } else if (arg == "-t") {
-        res.to = argv[++i].data();
-      } else if (arg == "-d") {
+  }
+  return res;
+}
+
+auto parseQueryTicket (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryTicket res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 's':
+        res.from = argv[++i];
+        break;
+      case 't':
+        res.to = argv[++i];
+        break;
+      case 'd':
         res.date = Date(argv[++i].data());
-      } else if (arg == "-p") {
-        res.sort = argv[++i].data()[0] == 't' ? kTime : kCost;
-      } else {
+        break;
+      case 'p':
+        res.sort = argv[++i][0] == 't' ? kTime : kCost;
+        break;
+      case 'k':
+        res.limit = atoi(argv[++i].data());
+        break;
+      case 'o':
+        res.offset = atoi(argv[++i].data());
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "query_transfer") {
-    QueryTransfer res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-s") {
-        res.from = argv[++i].data();
-      } else if (arg == "-t") {
-        res.to = argv[++i].data();
-      } else if (arg == "-d") {
+  }
+  return res;
+}
+
+auto parseQueryTransfer (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryTransfer res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 's':
+        res.from = argv[++i];
+        break;
+      case 't':
+        res.to = argv[++i];
+        break;
+      case 'd':
         res.date = Date(argv[++i].data());
-      } else if (arg == "-p") {
-        res.sort = argv[++i].data()[0] == 't' ? kTime : kCost;
-      } else {
+        break;
+      case 'p':
+        res.sort = argv[++i][0] == 't' ? kTime : kCost;
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "buy_ticket") {
-    BuyTicket res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-u") {
-        res.currentUser = argv[++i].data();
-      } else if (arg == "-i") {
-        res.train = argv[++i].data();
-      } else if (arg == "-d") {
+  }
+  return res;
+}
+
+auto parseQueryJourney (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryJourney res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 's':
+        res.from = argv[++i];
+        break;
+      case 't':
+        res.to = argv[++i];
+        break;
+      case 'd':
+        res.date = Date(argv[++i].data());
+        break;
+      case 'p':
+        res.sort = argv[++i][0] == 't' ? kTime : kCost;
+        break;
+      case 'n':
+        res.transfers = atoi(argv[++i].data());
+        break;
+      default:
+        return ParseException();
+    }
+  }
+  return res;
+}
+
+auto parseBuyTicket (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  BuyTicket res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'u':
+        res.currentUser = argv[++i];
+        break;
+      case 'i':
+        res.train = argv[++i];
+        break;
+      case 'd':
         res.date = Date(argv[++i].data());
-      } else if (arg == "-n") {
+        break;
+      case 'n':
         res.seats = atoi(argv[++i].data());
-      } else if (arg == "-f") {
-        res.from = argv[++i].data();
-      } else if (arg == "-t") {
-        res.to = argv[++i].data();
-      } else if (arg == "-q") {
-        res.queue = argv[++i].data()[0] == 't';
-      } else {
+        break;
+      case 'f':
+        res.from = argv[++i];
+        break;
+      case 't':
+        res.to = argv[++i];
+        break;
+      case 'q':
+        res.queue = argv[++i][0] == 't';
+        break;
+      default:
         return ParseException();
+    }
+  }
+  return res;
+}
+
+auto parseBuyTickets (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  BuyTickets res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'u':
+        res.currentUser = argv[++i];
+        break;
+      case 'i': {
+        res.trains = splitView(argv[++i], '|');
+        break;
+      }
+      case 'd': {
+        auto values = splitView(argv[++i], '|');
+        res.dates.reserve(values.size());
+        for (auto &str : values) {
+          res.dates.push_back(Date(str.data()));
+        }
+        break;
+      }
+      case 'n': {
+        auto values = splitView(argv[++i], '|');
+        res.seats.reserve(values.size());
+        for (auto &str : values) {
+          res.seats.push_back(atoi(str.data()));
+        }
+        break;
+      }
+      case 'f': {
+        res.from = splitView(argv[++i], '|');
+        break;
       }
+      case 't': {
+        res.to = splitView(argv[++i], '|');
+        break;
+      }
+      default:
+        return ParseException();
+    }
+  }
+  return res;
+}
+
+auto parseQueryOrder (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  QueryOrder res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
     }
-    return res;
-  } else if (argv0 == "query_order") {
-    QueryOrder res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-u") {
-        res.currentUser = argv[++i].data();
-      } else {
+    switch (arg[1]) {
+      case 'u':
+        res.currentUser = argv[++i];
+        break;
+      case 'k':
+        res.limit = atoi(argv[++i].data());
+        break;
+      case 'o':
+        res.offset = atoi(argv[++i].data());
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "refund_ticket") {
-    RefundTicket res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-u") {
-        res.currentUser = argv[++i].data();
-      } else if (arg == "-n") {
+  }
+  return res;
+}
+
+auto parseRefundTicket (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  RefundTicket res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 'u':
+        res.currentUser = argv[++i];
+        break;
+      case 'n':
         res.index = atoi(argv[++i].data());
-      } else {
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "rollback") {
-    Rollback res;
-    for (int i = 1; i < argv.size(); ++i) {
-      auto &arg = argv[i];
-      if (arg == "-t") {
+  }
+  return res;
+}
+
+auto parseRollback (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  Rollback res;
+  for (int i = 1; i < argv.size(); ++i) {
+    auto &arg = argv[i];
+    if (arg.length() != 2 || arg[0] != '-' || i + 1 == argv.size()) {
+      return ParseException();
+    }
+    switch (arg[1]) {
+      case 't':
         res.timestamp = atoi(argv[++i].data());
-      } else {
+        break;
+      default:
         return ParseException();
-      }
     }
-    return res;
-  } else if (argv0 == "clean") {
-    return Command(Clean());
-  } else if (argv0 == "exit") {
-    return Command(Exit());
-  } else {
-    return ParseException();
+  }
+  return res;
+}
+
+auto parseClean (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  return Command(Clean());
+}
+
+auto parseExit (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  return Command(Exit());
+}
+
+auto decodeAddUser (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  AddUser res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  res.username = in.string();
+  if (res.username.length() > 20) return ParseException();
+  res.password = in.string();
+  if (res.password.length() > 30) return ParseException();
+  res.name = in.string();
+  if (res.name.length() > 15) return ParseException();
+  res.email = in.string();
+  if (res.email.length() > 30) return ParseException();
+  res.privilege = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeLogin (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  Login res;
+  res.username = in.string();
+  if (res.username.length() > 20) return ParseException();
+  res.password = in.string();
+  if (res.password.length() > 30) return ParseException();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeLogout (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  Logout res;
+  res.username = in.string();
+  if (res.username.length() > 20) return ParseException();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryProfile (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryProfile res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  res.username = in.string();
+  if (res.username.length() > 20) return ParseException();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeModifyProfile (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  ModifyProfile res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  res.username = in.string();
+  if (res.username.length() > 20) return ParseException();
+  if (in.u8() != 0) {
+    auto value = in.string();
+    if (value.length() > 30) return ParseException();
+    res.password = value;
+  }
+  if (in.u8() != 0) {
+    auto value = in.string();
+    if (value.length() > 15) return ParseException();
+    res.name = value;
+  }
+  if (in.u8() != 0) {
+    auto value = in.string();
+    if (value.length() > 30) return ParseException();
+    res.email = value;
+  }
+  if (in.u8() != 0) res.privilege = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeAddTrain (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  AddTrain res;
+  res.id = in.string();
+  if (res.id.length() > 20) return ParseException();
+  res.stops = in.i32();
+  res.seats = in.i32();
+  {
+    auto n = in.u16();
+    if (n > 100) return ParseException();
+    res.stations.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      auto value = in.string();
+      if (value.length() > 30) return ParseException();
+      res.stations.push_back(value);
+    }
+  }
+  {
+    auto n = in.u16();
+    if (n > 99) return ParseException();
+    res.prices.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.prices.push_back(in.i32());
+    }
+  }
+  res.departure = in.instant();
+  {
+    auto n = in.u16();
+    if (n > 99) return ParseException();
+    res.durations.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.durations.push_back(Duration(in.i32()));
+    }
+  }
+  {
+    auto n = in.u16();
+    if (n > 99) return ParseException();
+    res.stopoverTimes.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.stopoverTimes.push_back(Duration(in.i32()));
+    }
+  }
+  {
+    auto n = in.u16();
+    res.dates.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.dates.push_back(in.date());
+    }
+  }
+  res.type = (char) in.u8();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeDeleteTrain (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  DeleteTrain res;
+  res.id = in.string();
+  if (res.id.length() > 20) return ParseException();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeReleaseTrain (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  ReleaseTrain res;
+  res.id = in.string();
+  if (res.id.length() > 20) return ParseException();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryTrain (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryTrain res;
+  res.id = in.string();
+  if (res.id.length() > 20) return ParseException();
+  res.date = in.date();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryTicket (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryTicket res;
+  res.from = in.string();
+  if (res.from.length() > 30) return ParseException();
+  res.to = in.string();
+  if (res.to.length() > 30) return ParseException();
+  res.date = in.date();
+  if (in.u8() != 0) res.sort = in.u8() == 0 ? kTime : kCost;
+  if (in.u8() != 0) res.limit = in.i32();
+  if (in.u8() != 0) res.offset = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryTransfer (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryTransfer res;
+  res.from = in.string();
+  if (res.from.length() > 30) return ParseException();
+  res.to = in.string();
+  if (res.to.length() > 30) return ParseException();
+  res.date = in.date();
+  if (in.u8() != 0) res.sort = in.u8() == 0 ? kTime : kCost;
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryJourney (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryJourney res;
+  res.from = in.string();
+  if (res.from.length() > 30) return ParseException();
+  res.to = in.string();
+  if (res.to.length() > 30) return ParseException();
+  res.date = in.date();
+  if (in.u8() != 0) res.sort = in.u8() == 0 ? kTime : kCost;
+  if (in.u8() != 0) res.transfers = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeBuyTicket (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  BuyTicket res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  res.train = in.string();
+  if (res.train.length() > 20) return ParseException();
+  res.date = in.date();
+  res.seats = in.i32();
+  res.from = in.string();
+  if (res.from.length() > 30) return ParseException();
+  res.to = in.string();
+  if (res.to.length() > 30) return ParseException();
+  if (in.u8() != 0) res.queue = in.u8() != 0;
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeBuyTickets (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  BuyTickets res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  {
+    auto n = in.u16();
+    res.trains.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      auto value = in.string();
+      if (value.length() > 20) return ParseException();
+      res.trains.push_back(value);
+    }
+  }
+  {
+    auto n = in.u16();
+    res.dates.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.dates.push_back(in.date());
+    }
+  }
+  {
+    auto n = in.u16();
+    res.seats.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      res.seats.push_back(in.i32());
+    }
+  }
+  {
+    auto n = in.u16();
+    res.from.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      auto value = in.string();
+      if (value.length() > 30) return ParseException();
+      res.from.push_back(value);
+    }
+  }
+  {
+    auto n = in.u16();
+    res.to.reserve(n);
+    for (unsigned i = 0; i < n && in.ok(); ++i) {
+      auto value = in.string();
+      if (value.length() > 30) return ParseException();
+      res.to.push_back(value);
+    }
+  }
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeQueryOrder (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  QueryOrder res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  if (in.u8() != 0) res.limit = in.i32();
+  if (in.u8() != 0) res.offset = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeRefundTicket (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  RefundTicket res;
+  res.currentUser = in.string();
+  if (res.currentUser.length() > 20) return ParseException();
+  if (in.u8() != 0) res.index = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeRollback (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  Rollback res;
+  res.timestamp = in.i32();
+  if (!in.done()) return ParseException();
+  return res;
+}
+
+auto decodeClean (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  if (!in.done()) return ParseException();
+  return Command(Clean());
+}
+
+auto decodeExit (binary::Reader &in)
+  -> Result<Command, ParseException> {
+  if (!in.done()) return ParseException();
+  return Command(Exit());
+}
+
+} // namespace
+
+auto parse (std::string &str)
+  -> Result<Command, ParseException> {
+  auto argv = split(str, ' ');
+  return parse(argv);
+}
+
+auto parse (const Vector<std::string_view> &argv)
+  -> Result<Command, ParseException> {
+  auto &argv0 = argv[0];
+  switch (argv0.length()) {
+    case 4:
+      if (argv0 == "exit") return parseExit(argv);
+      break;
+    case 5:
+      switch (argv0[0]) {
+        case 'l':
+          if (argv0 == "login") return parseLogin(argv);
+          break;
+        case 'c':
+          if (argv0 == "clean") return parseClean(argv);
+          break;
+      }
+      break;
+    case 6:
+      if (argv0 == "logout") return parseLogout(argv);
+      break;
+    case 8:
+      switch (argv0[0]) {
+        case 'a':
+          if (argv0 == "add_user") return parseAddUser(argv);
+          break;
+        case 'r':
+          if (argv0 == "rollback") return parseRollback(argv);
+          break;
+      }
+      break;
+    case 9:
+      if (argv0 == "add_train") return parseAddTrain(argv);
+      break;
+    case 10:
+      if (argv0 == "buy_ticket") return parseBuyTicket(argv);
+      break;
+    case 11:
+      switch (argv0[6]) {
+        case 't':
+          if (argv0 == "query_train") return parseQueryTrain(argv);
+          break;
+        case 'c':
+          if (argv0 == "buy_tickets") return parseBuyTickets(argv);
+          break;
+        case 'o':
+          if (argv0 == "query_order") return parseQueryOrder(argv);
+          break;
+      }
+      break;
+    case 12:
+      switch (argv0[0]) {
+        case 'd':
+          if (argv0 == "delete_train") return parseDeleteTrain(argv);
+          break;
+        case 'q':
+          if (argv0 == "query_ticket") return parseQueryTicket(argv);
+          break;
+      }
+      break;
+    case 13:
+      switch (argv0[6]) {
+        case 'p':
+          if (argv0 == "query_profile") return parseQueryProfile(argv);
+          break;
+        case 'e':
+          if (argv0 == "release_train") return parseReleaseTrain(argv);
+          break;
+        case 'j':
+          if (argv0 == "query_journey") return parseQueryJourney(argv);
+          break;
+        case '_':
+          if (argv0 == "refund_ticket") return parseRefundTicket(argv);
+          break;
+      }
+      break;
+    case 14:
+      switch (argv0[0]) {
+        case 'm':
+          if (argv0 == "modify_profile") return parseModifyProfile(argv);
+          break;
+        case 'q':
+          if (argv0 == "query_transfer") return parseQueryTransfer(argv);
+          break;
+      }
+      break;
+  }
+  return ParseException();
+}
+
+auto decode (std::string_view body)
+  -> Result<Command, ParseException> {
+  binary::Reader in(body);
+  // the tag is the index of the command in commands.yml.
+  switch (in.u8()) {
+    case 0:
+      return decodeAddUser(in);
+    case 1:
+      return decodeLogin(in);
+    case 2:
+      return decodeLogout(in);
+    case 3:
+      return decodeQueryProfile(in);
+    case 4:
+      return decodeModifyProfile(in);
+    case 5:
+      return decodeAddTrain(in);
+    case 6:
+      return decodeDeleteTrain(in);
+    case 7:
+      return decodeReleaseTrain(in);
+    case 8:
+      return decodeQueryTrain(in);
+    case 9:
+      return decodeQueryTicket(in);
+    case 10:
+      return decodeQueryTransfer(in);
+    case 11:
+      return decodeQueryJourney(in);
+    case 12:
+      return decodeBuyTicket(in);
+    case 13:
+      return decodeBuyTickets(in);
+    case 14:
+      return decodeQueryOrder(in);
+    case 15:
+      return decodeRefundTicket(in);
+    case 16:
+      return decodeRollback(in);
+    case 17:
+      return decodeClean(in);
+    case 18:
+      return decodeExit(in);
+    default:
+      return ParseException();
   }
 }
 
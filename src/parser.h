@@ -4,6 +4,7 @@
 #define TICKET_PARSER_H_
 
 #include <iostream>
+#include <string_view>
 
 #include "datetime.h"
 #include "exception.h"
@@ -17,42 +18,42 @@ namespace ticket::command {
 enum SortType { kTime, kCost };
 
 struct AddUser {
-  std::string currentUser;
-  std::string username;
-  std::string password;
-  std::string name;
-  std::string email;
+  std::string_view currentUser;
+  std::string_view username;
+  std::string_view password;
+  std::string_view name;
+  std::string_view email;
   int privilege;
 };
 
 struct Login {
-  std::string username;
-  std::string password;
+  std::string_view username;
+  std::string_view password;
 };
 
 struct Logout {
-  std::string username;
+  std::string_view username;
 };
 
 struct QueryProfile {
-  std::string currentUser;
-  std::string username;
+  std::string_view currentUser;
+  std::string_view username;
 };
 
 struct ModifyProfile {
-  std::string currentUser;
-  std::string username;
-  Optional<std::string> password;
-  Optional<std::string> name;
-  Optional<std::string> email;
+  std::string_view currentUser;
+  std::string_view username;
+  Optional<std::string_view> password;
+  Optional<std::string_view> name;
+  Optional<std::string_view> email;
   Optional<int> privilege;
 };
 
 struct AddTrain {
-  std::string id;
+  std::string_view id;
   int stops;
   int seats;
-  Vector<std::string> stations;
+  Vector<std::string_view> stations;
   Vector<int> prices;
   Instant departure;
   Vector<Duration> durations;
@@ -62,48 +63,69 @@ struct AddTrain {
 };
 
 struct DeleteTrain {
-  std::string id;
+  std::string_view id;
 };
 
 struct ReleaseTrain {
-  std::string id;
+  std::string_view id;
 };
 
 struct QueryTrain {
-  std::string id;
+  std::string_view id;
   Date date;
 };
 
 struct QueryTicket {
-  std::string from;
-  std::string to;
+  std::string_view from;
+  std::string_view to;
   Date date;
   SortType sort = kTime;
+  Optional<int> limit;
+  int offset = 0;
 };
 
 struct QueryTransfer {
-  std::string from;
-  std::string to;
+  std::string_view from;
+  std::string_view to;
   Date date;
   SortType sort = kTime;
 };
 
+struct QueryJourney {
+  std::string_view from;
+  std::string_view to;
+  Date date;
+  SortType sort = kTime;
+  int transfers = 2;
+};
+
 struct BuyTicket {
-  std::string currentUser;
-  std::string train;
+  std::string_view currentUser;
+  std::string_view train;
   Date date;
   int seats;
-  std::string from;
-  std::string to;
+  std::string_view from;
+  std::string_view to;
   bool queue = false;
 };
 
+struct BuyTickets {
+  std::string_view currentUser;
+  Vector<std::string_view> trains;
+  Vector<Date> dates;
+  Vector<int> seats;
+  Vector<std::string_view> from;
+  Vector<std::string_view> to;
+};
+
 struct QueryOrder {
-  std::string currentUser;
+  std::string_view currentUser;
+  Optional<int> limit;
+  int offset = 0;
 };
 
 struct RefundTicket {
-  std::string currentUser;
+  std::string_view currentUser;
   int index = 1;
 };
 
@@ -132,7 +154,9 @@ using Command = Variant<
   QueryTrain,
   QueryTicket,
   QueryTransfer,
+  QueryJourney,
   BuyTicket,
+  BuyTickets,
   QueryOrder,
   RefundTicket,
   Rollback,
@@ -143,12 +167,40 @@ using Command = Variant<
 /**
  * @brief parses the command stored in str.
  *
+ * the strings in the command are views into str, so str
+ * must outlive the command.
+ *
  * this function is autogenerated.
  */
 auto parse (std::string &str)
   -> Result<Command, ParseException>;
 auto parse (const Vector<std::string_view> &argv)
   -> Result<Command, ParseException>;
+/**
+ * @brief decodes a command in the binary protocol, i.e. its
+ * tag and its arguments, see protocol.h.
+ *
+ * the strings in the command are views into body.
+ *
+ * this function is autogenerated.
+ */
+auto decode (std::string_view body)
+  -> Result<Command, ParseException>;
+
+/**
+ * @brief checks if the command only reads the data, i.e. if
+ * it is a query.
+ *
+ * this function is autogenerated.
+ */
+inline auto isReadOnly (const Command &cmd) -> bool {
+  return cmd.is<QueryProfile>()
+    || cmd.is<QueryTrain>()
+    || cmd.is<QueryTicket>()
+    || cmd.is<QueryTransfer>()
+    || cmd.is<QueryJourney>()
+    || cmd.is<QueryOrder>();
+}
 
 } // namespace ticket::command
 
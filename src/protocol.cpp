@@ -0,0 +1,130 @@
+#include "protocol.h"
+
+#include "binary.h"
+#include "response.h"
+#include "run.h"
+
+namespace ticket {
+
+namespace {
+
+enum Status { kError, kOk, kBye };
+
+/// runs the command, an Exception thrown failing it as if
+/// returned, so that a bad request does not end the process.
+template <typename Args>
+auto tryRun (const Args &args) -> Result<Response, Exception> {
+  try {
+    return command::run(args);
+  } catch (const Exception &e) {
+    return e;
+  }
+}
+
+} // namespace
+
+auto splitFrame (Protocol protocol, std::string_view buf,
+  std::string_view &body) -> size_t {
+  if (protocol == Protocol::kText) {
+    auto newline = buf.find('\n');
+    if (newline == std::string_view::npos) return 0;
+    body = buf.substr(0, newline);
+    return newline + 1;
+  }
+  binary::Reader in(buf);
+  size_t length = in.u32();
+  if (!in.ok() || buf.length() - 4 < length) return 0;
+  body = buf.substr(4, length);
+  return length + 4;
+}
+
+auto readFrame (Protocol protocol, std::string_view body, Frame &frame)
+  -> void {
+  frame.eof = false;
+  frame.timestamp = 0;
+  if (protocol == Protocol::kBinary) {
+    // the command views the body, so it is kept in the frame.
+    frame.line.assign(body);
+    binary::Reader in(frame.line);
+    frame.timestamp = in.i32();
+    frame.parsed = false;
+    if (!in.ok()) return;
+    auto res = command::decode(std::string_view(frame.line).substr(4));
+    frame.parsed = res.success();
+    if (frame.parsed) frame.cmd = std::move(res.result());
+    return;
+  }
+  // "[timestamp] command"
+  size_t i = 1;
+  while (i < body.length() && body[i] >= '0' && body[i] <= '9') {
+    frame.timestamp = frame.timestamp * 10 + (body[i++] - '0');
+  }
+  i = i + 2 < body.length() ? i + 2 : body.length();
+  frame.line.assign(body.substr(i));
+  auto res = command::parse(frame.line);
+  frame.parsed = res.success();
+  if (frame.parsed) frame.cmd = std::move(res.result());
+}
+
+auto execute (Protocol protocol, const command::Command &cmd) -> void {
+  auto &out = response::out;
+  if (protocol == Protocol::kBinary) {
+    cmd.visit([&out] (const auto &args) {
+      auto res = tryRun(args);
+      if (res.error()) {
+        writeError(Protocol::kBinary, res.error()->what());
+        return;
+      }
+      out.u8(kOk).u8(res.result().index());
+      res.result().visit([] (const auto &res) { response::encode(res); });
+    });
+    return;
+  }
+  cmd.visit([&out] (const auto &args) {
+    auto res = tryRun(args);
+    if (res.error()) {
+      if constexpr (isInteractive) {
+        out << "\x1b[31m" << res.error()->what() << "\x1b[0m\n";
+      } else {
+        out << "-1\n";
+      }
+    } else {
+      if constexpr (isInteractive) out << "\x1b[32m";
+      res.result().visit([] (const auto &res) { response::cout(res); });
+      if constexpr (isInteractive) out << "\x1b[0m";
+    }
+  });
+}
+
+auto writeReply (Protocol protocol, const Frame &frame) -> void {
+  auto &out = response::out;
+  if (protocol == Protocol::kBinary) {
+    out.u32(4 + frame.reply.length()).i32(frame.timestamp) << frame.reply;
+  } else {
+    out << '[' << frame.timestamp << "] " << frame.reply;
+  }
+}
+
+auto writeError (Protocol protocol, const char *message) -> void {
+  auto &out = response::out;
+  if (protocol == Protocol::kBinary) {
+    out.u8(kError).string(message);
+  } else {
+    out << "-1\n";
+  }
+}
+
+auto writeParseError (Protocol protocol) -> void {
+  writeError(protocol, "invalid command");
+}
+
+auto writeBye (Protocol protocol) -> void {
+  auto &out = response::out;
+  if (protocol == Protocol::kBinary) {
+    out.u8(kBye);
+  } else {
+    out << "bye\n";
+  }
+}
+
+} // namespace ticket
@@ -0,0 +1,92 @@
+// This file defines the wire formats of the commands and
+// their responses.
+#ifndef TICKET_PROTOCOL_H_
+#define TICKET_PROTOCOL_H_
+
+#include <string>
+#include <string_view>
+
+#include "parser.h"
+
+namespace ticket {
+
+/**
+ * @brief The wire formats.
+ *
+ * In kText, a request is a line "[timestamp] command", and
+ * its response is "[timestamp] " followed by the text the
+ * REPL prints.
+ *
+ * In kBinary, every request and response is a frame: a
+ * 4-byte length, and that many bytes of body. All integers
+ * are little-endian, see binary::Reader.
+ *
+ * A request body is the timestamp as 4 bytes, the tag of
+ * the command as a byte, i.e. its index in commands.yml,
+ * and the arguments in the order of commands.yml. Optional
+ * arguments and the ones with defaults are prefixed by a
+ * byte, 1 if they are present. int and Duration are 4
+ * bytes, bool, char and SortType (0 for time, 1 for cost)
+ * are a byte, Date is the month and the day and Instant is
+ * the hour and the minute, a byte each. strings are
+ * prefixed by their lengths as 2 bytes, and arrays by their
+ * sizes as 2 bytes.
+ *
+ * A response body is the timestamp as 4 bytes and a status
+ * byte. After status 0, an error, comes the message as a
+ * string. After status 1, a success, comes the index of the
+ * type in Response as a byte and the data, see
+ * response::encode(). Status 2 is the response to exit.
+ */
+enum class Protocol { kText, kBinary };
+
+/// A request, i.e. a timestamp and a command.
+struct Frame {
+  /// the end of the input, with no command.
+  bool eof = false;
+  int timestamp = 0;
+  /// the body of the request, which the strings in cmd
+  /// view.
+  std::string line;
+  bool parsed = false;
+  command::Command cmd;
+  /// the response, if it is run apart from the output.
+  std::string reply;
+};
+
+/**
+ * @brief finds the first request in buf.
+ *
+ * @param body set to the body of the request.
+ * @return the number of bytes the request takes, or 0 if
+ *   buf does not hold a whole one.
+ */
+auto splitFrame (Protocol protocol, std::string_view buf,
+  std::string_view &body) -> size_t;
+/// parses the body of a request into frame.
+auto readFrame (Protocol protocol, std::string_view body, Frame &frame)
+  -> void;
+
+/**
+ * @brief runs the command, and writes the body of its
+ * response to response::out.
+ *
+ * an Exception thrown by the command gets an error, like
+ * one returned. in kBinary, the exit command is up to the
+ * caller.
+ */
+auto execute (Protocol protocol, const command::Command &cmd) -> void;
+/// writes the response to the frame, whose body is in
+/// frame.reply, to response::out.
+auto writeReply (Protocol protocol, const Frame &frame) -> void;
+/// writes the body of the response to a command failing.
+auto writeError (Protocol protocol, const char *message) -> void;
+/// writes the body of the response to a request failing
+/// to parse.
+auto writeParseError (Protocol protocol) -> void;
+/// writes the body of the response to exit.
+auto writeBye (Protocol protocol) -> void;
+
+} // namespace ticket
+
+#endif // TICKET_PROTOCOL_H_
@@ -3,20 +3,24 @@
 #include "exception.h"
 #include "train.h"
 
+#include <unistd.h>
+
 #include <cstddef>
-#include <iostream>
+#include <string>
 
 namespace ticket::response {
 
+thread_local Writer out(STDOUT_FILENO);
+
 auto cout (const Unit & /* unused */) -> void {
   if constexpr (isInteractive) {
-    std::cout << "success!\n";
+    out << "success!\n";
   } else {
-    std::cout << "0\n";
+    out << "0\n";
   }
 }
 auto cout (const User &user) -> void {
-  std::cout
+  out
     << user.username << ' '
     << user.name << ' '
     << user.email << ' '
@@ -24,23 +28,23 @@ auto cout (const User &user) -> void {
 }
 auto cout (const BuyTicketResponse &ticket) -> void {
   if (auto succ = ticket.get<BuyTicketSuccess>()) {
-    std::cout << succ->price << '\n';
+    out << succ->price << '\n';
   } else {
-    std::cout << "queue\n";
+    out << "queue\n";
   }
 }
 auto cout (const Vector<Order> &orders) -> void {
-  std::cout << orders.size() << '\n';
+  out << orders.size() << '\n';
   for (const auto &order : orders) {
     const auto &cache = order.cache;
     auto date = order.ride.date;
-    std::cout
+    out
       << '[' << Order::statusString(order.status) << "] "
-      << cache.trainId.str() << ' '
-      << cache.from.str() << ' '
-      << formatDateTime(date, cache.timeDeparture) << " -> "
-      << cache.to.str() << ' '
-      << formatDateTime(date, cache.timeArrival) << ' '
+      << cache.trainId << ' '
+      << cache.from << ' ';
+    out.dateTime(date, cache.timeDeparture) << " -> "
+      << cache.to << ' ';
+    out.dateTime(date, cache.timeArrival) << ' '
       << order.price << ' '
       << order.seats << '\n';
   }
@@ -52,37 +56,100 @@ auto cout (const Vector<Order> &orders) -> void {
 */
 auto cout (const RideSeats &rd) -> void{
   Train train = Train::get( rd.ride.train );
-  std::cout << train.trainId << ' ' << train.type << '\n';
+  out << train.trainId << ' ' << train.type << '\n';
 
   // from
-  std::cout << train.stops[0] << " xx-xx xx:xx -> ";
+  out << train.stops[0] << " xx-xx xx:xx -> ";
 
-  long long tot_price = 0;
   for(int i = 0; i < train.edges.size(); ++ i){
-    std :: cout <<
-    formatDateTime( rd.ride.date, train.edges[i].departure )
-    << ' ' << tot_price << ' ' << rd.seatsRemaining[i] <<'\n'
-    << train.stops[i + 1] << ' ' <<
-    formatDateTime( rd.ride.date, train.edges[i].arrival )
-    << " -> ";
-
-    tot_price += train.edges[i].price;
+    out.dateTime( rd.ride.date, train.edges[i].departure )
+      << ' ' << train.prices[i] << ' ' << rd.seatsRemaining[i] <<'\n'
+      << train.stops[i + 1] << ' ';
+    out.dateTime( rd.ride.date, train.edges[i].arrival ) << " -> ";
   }
   //to
-  std::cout << "xx-xx xx:xx " << tot_price << " x\n";
+  out << "xx-xx xx:xx " << train.prices[train.edges.size()]
+    << " x\n";
 }
 auto cout (const Vector<Range> & ranges) -> void{
-  std::cout << ranges.size() << '\n';
+  out << ranges.size() << '\n';
   for(auto &ele: ranges)
     ele.output();
 }
 auto cout (const Sol & sol) -> void{
   if(sol.empty()){
-    std::cout << "0\n";
+    out << "0\n";
     return ;
   }
   sol.output();
 }
+auto cout (const Journey &journey) -> void {
+  cout(journey.legs);
+}
+
+auto encode (const Unit & /* unused */) -> void {}
+auto encode (const User &user) -> void {
+  out
+    .string(user.username.view())
+    .string(user.name.view())
+    .string(user.email.view())
+    .i32(user.privilege);
+}
+auto encode (const BuyTicketResponse &ticket) -> void {
+  if (auto succ = ticket.get<BuyTicketSuccess>()) {
+    out.u8(0).i64(succ->price);
+  } else {
+    out.u8(1);
+  }
+}
+auto encode (const Vector<Order> &orders) -> void {
+  out.u32(orders.size());
+  for (const auto &order : orders) {
+    const auto &cache = order.cache;
+    auto date = order.ride.date;
+    out.u8(order.status)
+      .string(cache.trainId.view())
+      .string(cache.from.view())
+      .rawDateTime(date, cache.timeDeparture)
+      .string(cache.to.view())
+      .rawDateTime(date, cache.timeArrival)
+      .i64(order.price)
+      .i32(order.seats);
+  }
+}
+auto encode (const RideSeats &rd) -> void {
+  Train train = Train::get(rd.ride.train);
+  int edges = train.edges.size();
+  out.string(train.trainId.view()).u8(train.type).u16(edges + 1);
+  for (int i = 0; i <= edges; ++i) {
+    out.string(train.stops[i].view());
+    if (i == 0) {
+      out.u32(0);
+    } else {
+      out.rawDateTime(rd.ride.date, train.edges[i - 1].arrival);
+    }
+    if (i == edges) {
+      out.u32(0);
+    } else {
+      out.rawDateTime(rd.ride.date, train.edges[i].departure);
+    }
+    out.i64(train.prices[i]).i32(i == edges ? 0 : rd.seatsRemaining[i]);
+  }
+}
+auto encode (const Vector<Range> &ranges) -> void {
+  out.u32(ranges.size());
+  for (const auto &range : ranges) range.encode();
+}
+auto encode (const Sol &sol) -> void {
+  if (sol.empty()) {
+    out.u32(0);
+    return;
+  }
+  encode(sol.legs());
+}
+auto encode (const Journey &journey) -> void {
+  encode(journey.legs);
+}
 
 
 #ifdef BUILD_NODEJS
@@ -91,9 +158,75 @@ auto cout (const Sol & sol) -> void{
 #define JS_STR(x) Napi::String::New(env, x)
 #define JS_NUM(x) Napi::Number::New(env, x)
 #define JS_ARR(length) Napi::Array::New(env, length)
-#define JS_DATE(date, instant) \
-  Napi::Value(env.Global()["Date"]).As<Napi::Function>() \
-  .New({ JS_STR(formatDateTime(date, instant)) });
+#define JS_TIME(date, instant) JS_NUM(epochMs(date, instant))
+
+namespace {
+
+/// the lists of at least so many rows are packed.
+constexpr size_t kPackRows = 32;
+/// 2021-06-01T00:00Z, the first Date.
+constexpr double kEpochMs = 1622505600000;
+
+/// gets the time as milliseconds since the Unix epoch,
+/// taking the wall clock as UTC.
+auto epochMs (Date date, Instant instant) -> double {
+  int days = date - Date(6, 1) + instant.daysOverflow();
+  int minutes = days * 24 * 60 + instant.hour() * 60 + instant.minute();
+  return kEpochMs + minutes * 60000.0;
+}
+
+/**
+ * @brief packs the response into an ArrayBuffer, in the
+ * binary protocol.
+ *
+ * the buffer takes the bytes over, with no copy. JS decodes
+ * the rows lazily, see response.js.
+ */
+template <typename T>
+auto pack (Napi::Env env, const char *type, size_t length, const T &res)
+  -> Napi::Object {
+  auto *bytes = new std::string;
+  out.capture(bytes);
+  encode(res);
+  out.capture(nullptr);
+  auto obj = JS_OBJ();
+  obj["type"] = JS_STR(type);
+  obj["length"] = JS_NUM(length);
+  obj["buffer"] = Napi::ArrayBuffer::New(env, bytes->data(),
+    bytes->length(), [] (Napi::Env, void *, std::string *str) {
+      delete str;
+    }, bytes);
+  return obj;
+}
+
+/// the keys of the rows, created once for a list.
+struct RangeKeys {
+  Napi::String trainId, from, departure, to, arrival, price, seats;
+  explicit RangeKeys (Napi::Env env)
+    : trainId(JS_STR("trainId")), from(JS_STR("from")),
+      departure(JS_STR("departure")), to(JS_STR("to")),
+      arrival(JS_STR("arrival")), price(JS_STR("price")),
+      seats(JS_STR("seats")) {}
+};
+
+auto rangeToJs (Napi::Env env, const RangeKeys &keys, const Range &range)
+  -> Napi::Object {
+  const Train &train = Train::get(range.rd.ride.train);
+  auto date = range.rd.ride.date;
+  auto obj = JS_OBJ();
+  obj.Set(keys.trainId, JS_STR(train.trainId.str()));
+  obj.Set(keys.from, JS_STR(train.stops[range.ixFrom].str()));
+  obj.Set(keys.departure,
+    JS_TIME(date, train.edges[range.ixFrom].departure));
+  obj.Set(keys.to, JS_STR(train.stops[range.ixTo].str()));
+  obj.Set(keys.arrival, JS_TIME(date, train.edges[range.ixTo - 1].arrival));
+  obj.Set(keys.price, JS_NUM(range.totalPrice));
+  obj.Set(keys.seats,
+    JS_NUM(range.rd.ticketsAvailable(range.ixFrom, range.ixTo)));
+  return obj;
+}
+
+} // namespace
 
 auto toJsObject (Napi::Env env, const Unit & /* unused */)
   -> Napi::Object {
@@ -110,14 +243,6 @@ auto toJsObject (Napi::Env env, const User &user)
   obj["privilege"] = JS_NUM(user.privilege);
   return obj;
 }
-auto toJsObject (Napi::Env env, const Train &train)
-  -> Napi::Object {
-  // TODO
-}
-auto toJsObject (Napi::Env env, const Vector<Train> &trains)
-  -> Napi::Object {
-  // TODO
-}
 
 auto toJsObject (
   Napi::Env env,
@@ -135,29 +260,90 @@ auto toJsObject (
 
 auto toJsObject (Napi::Env env, const Vector<Order> &orders)
   -> Napi::Object {
-  auto arr = JS_ARR(0);
+  if (orders.size() >= kPackRows) {
+    return pack(env, "orders", orders.size(), orders);
+  }
+  RangeKeys keys(env);
+  auto status = JS_STR("status");
+  auto subTotal = JS_STR("subTotal");
+  auto arr = JS_ARR(orders.size());
   for (int i = 0; i < orders.size(); ++i) {
-    auto jsOrder = JS_OBJ();
-    arr[i] = jsOrder;
     const auto &order = orders[i];
     const auto &cache = order.cache;
     auto date = order.ride.date;
-    jsOrder["id"] = JS_NUM(order.id());
-    jsOrder["trainId"] = JS_STR(cache.trainId.str());
-    jsOrder["from"] = JS_DATE(date, cache.timeDeparture);
-    jsOrder["to"] = JS_DATE(date, cache.timeArrival);
-    jsOrder["price"] = JS_NUM(order.price);
-    jsOrder["seats"] = JS_NUM(order.seats);
-    jsOrder["subTotal"] = JS_NUM(order.getSubTotal());
+    auto jsOrder = JS_OBJ();
+    jsOrder.Set(status, JS_STR(Order::statusString(order.status)));
+    jsOrder.Set(keys.trainId, JS_STR(cache.trainId.str()));
+    jsOrder.Set(keys.from, JS_STR(cache.from.str()));
+    jsOrder.Set(keys.departure, JS_TIME(date, cache.timeDeparture));
+    jsOrder.Set(keys.to, JS_STR(cache.to.str()));
+    jsOrder.Set(keys.arrival, JS_TIME(date, cache.timeArrival));
+    jsOrder.Set(keys.price, JS_NUM(order.price));
+    jsOrder.Set(keys.seats, JS_NUM(order.seats));
+    jsOrder.Set(subTotal, JS_NUM(order.getSubTotal()));
+    arr.Set(i, jsOrder);
   }
   return arr;
 }
 
+auto toJsObject (Napi::Env env, const RideSeats &rd)
+  -> Napi::Object {
+  Train train = Train::get(rd.ride.train);
+  auto station = JS_STR("station");
+  auto arrival = JS_STR("arrival");
+  auto departure = JS_STR("departure");
+  auto price = JS_STR("price");
+  auto seats = JS_STR("seats");
+  int edges = train.edges.size();
+  auto stops = JS_ARR(edges + 1);
+  for (int i = 0; i <= edges; ++i) {
+    auto stop = JS_OBJ();
+    stop.Set(station, JS_STR(train.stops[i].str()));
+    // null where the text output has xx-xx xx:xx.
+    stop.Set(arrival, i == 0 ? env.Null()
+      : JS_TIME(rd.ride.date, train.edges[i - 1].arrival));
+    stop.Set(departure, i == edges ? env.Null()
+      : JS_TIME(rd.ride.date, train.edges[i].departure));
+    stop.Set(price, JS_NUM(train.prices[i]));
+    stop.Set(seats, i == edges ? env.Null() : JS_NUM(rd.seatsRemaining[i]));
+    stops.Set(i, stop);
+  }
+  auto obj = JS_OBJ();
+  obj["trainId"] = JS_STR(train.trainId.str());
+  obj["type"] = JS_STR(std::string(1, train.type));
+  obj["stops"] = stops;
+  return obj;
+}
+
+auto toJsObject (Napi::Env env, const Vector<Range> &ranges)
+  -> Napi::Object {
+  if (ranges.size() >= kPackRows) {
+    return pack(env, "ranges", ranges.size(), ranges);
+  }
+  RangeKeys keys(env);
+  auto arr = JS_ARR(ranges.size());
+  for (int i = 0; i < ranges.size(); ++i) {
+    arr.Set(i, rangeToJs(env, keys, ranges[i]));
+  }
+  return arr;
+}
+
+auto toJsObject (Napi::Env env, const Sol &sol)
+  -> Napi::Object {
+  if (sol.empty()) return JS_ARR(0);
+  return toJsObject(env, sol.legs());
+}
+
+auto toJsObject (Napi::Env env, const Journey &journey)
+  -> Napi::Object {
+  return toJsObject(env, journey.legs);
+}
+
 #undef JS_OBJ
 #undef JS_STR
 #undef JS_NUM
 #undef JS_ARR
-#undef JS_DATE
+#undef JS_TIME
 
 #endif // BUILD_NODEJS
 
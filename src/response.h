@@ -6,11 +6,13 @@
 #include <napi.h>
 #endif // BUILD_NODEJS
 
+#include "journey.h"
 #include "order.h"
 #include "train.h"
 #include "user.h"
 #include "utility.h"
 #include "variant.h"
+#include "writer.h"
 
 namespace ticket {
 
@@ -21,7 +23,8 @@ using Response = Variant<
   Vector<Order>,
   RideSeats,
   Vector<Range>,
-  Sol
+  Sol,
+  Journey
   // the exit command does not need a response object.
 >;
 
@@ -34,6 +37,15 @@ constexpr static bool isInteractive =
 
 namespace response {
 
+/**
+ * @brief the standard output, which all responses go
+ * through.
+ *
+ * each thread has its own, so that concurrent queries can
+ * capture their responses, see scheduler.h.
+ */
+extern thread_local Writer out;
+
 //  corrections guar
 auto cout (const Unit & /* unused */) -> void;
 auto cout (const User &user) -> void;
@@ -42,15 +54,53 @@ auto cout (const Vector<Order> &orders) -> void;
 auto cout (const RideSeats &rd) -> void;// for "QueryTrain"
 auto cout (const Vector<Range> & ranges) -> void;// for "QueryTicket"
 auto cout (const Sol & sol) -> void;// for "QueryTransfer"
+auto cout (const Journey &journey) -> void;
+
+/**
+ * @brief writes the data of the response in the binary
+ * protocol, see protocol.h.
+ *
+ * datetimes are 4 bytes, see Writer::rawDateTime(), and
+ * zeros where the text output has xx-xx xx:xx. prices are 8
+ * bytes. lists are prefixed by their sizes as 4 bytes,
+ * except the stops of a train, prefixed as 2 bytes.
+ */
+auto encode (const Unit & /* unused */) -> void;
+/// username, name, email, privilege as 4 bytes.
+auto encode (const User &user) -> void;
+/// 1 if queued, or 0 and the price.
+auto encode (const BuyTicketResponse &ticket) -> void;
+/// status as a byte, train, from, departure, to, arrival,
+/// price and seats as 4 bytes, for every order.
+auto encode (const Vector<Order> &orders) -> void;
+/// train, type as a byte, and for every stop its station,
+/// arrival, departure, the price from the first stop and
+/// the seats to the next stop as 4 bytes.
+auto encode (const RideSeats &rd) -> void;
+/// train, from, departure, to, arrival, price and seats as
+/// 4 bytes, for every range.
+auto encode (const Vector<Range> &ranges) -> void;
+/// the two rides as ranges, or none.
+auto encode (const Sol &sol) -> void;
+auto encode (const Journey &journey) -> void;
 
 #ifdef BUILD_NODEJS
 
+/**
+ * @brief converts the response to JS.
+ *
+ * times are milliseconds since the Unix epoch, taking the
+ * wall clock as UTC. lists of many rows are packed into an
+ * ArrayBuffer instead, see response.d.ts.
+ */
 auto toJsObject (Napi::Env env, const Unit & /* unused */) -> Napi::Object;
 auto toJsObject (Napi::Env env, const User &user) -> Napi::Object;
-auto toJsObject (Napi::Env env, const Train &train) -> Napi::Object;
-auto toJsObject (Napi::Env env, const Vector<Train> &trains) -> Napi::Object;
 auto toJsObject (Napi::Env env, const BuyTicketResponse &ticket) -> Napi::Object;
 auto toJsObject (Napi::Env env, const Vector<Order> &orders) -> Napi::Object;
+auto toJsObject (Napi::Env env, const RideSeats &rd) -> Napi::Object;
+auto toJsObject (Napi::Env env, const Vector<Range> &ranges) -> Napi::Object;
+auto toJsObject (Napi::Env env, const Sol &sol) -> Napi::Object;
+auto toJsObject (Napi::Env env, const Journey &journey) -> Napi::Object;
 
 #endif // BUILD_NODEJS
 
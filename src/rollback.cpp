@@ -1,23 +1,305 @@
 #include "rollback.h"
 
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
 #include "exception.h"
+#include "file/append-log.h"
+#include "file/checkpoint.h"
+#include "journey.h"
 #include "parser.h"
 #include "run.h"
+#include "vector.h"
 
 namespace ticket {
 
+namespace {
+
+/**
+ * @brief Writes a log entry into a buffer.
+ *
+ * An entry is a tag byte, i.e. the index of its content in
+ * LogEntry::Content, followed by the timestamp and the
+ * fields of the content as varints. strings are prefixed
+ * with their lengths.
+ */
+class Encoder {
+ public:
+  auto byte (int value) -> void { buf_[length_++] = value; }
+  auto varint (int value) -> void {
+    auto x = (unsigned) value;
+    while (x >= 0x80) {
+      buf_[length_++] = x | 0x80;
+      x >>= 7;
+    }
+    buf_[length_++] = x;
+  }
+  auto string (const std::string &str) -> void {
+    varint(str.length());
+    memcpy(buf_ + length_, str.data(), str.length());
+    length_ += str.length();
+  }
+  auto data () const -> const char * { return buf_; }
+  auto length () const -> size_t { return length_; }
+ private:
+  // large enough for the largest entry, ModifyProfile.
+  char buf_[256];
+  size_t length_ = 0;
+};
+/// Reads a log entry written by Encoder.
+class Decoder {
+ public:
+  Decoder (std::string_view buf) : buf_(buf) {}
+  auto byte () -> int { return (unsigned char) buf_[pos_++]; }
+  auto varint () -> int {
+    unsigned x = 0;
+    for (int shift = 0; ; shift += 7) {
+      auto b = (unsigned char) buf_[pos_++];
+      x |= (unsigned) (b & 0x7f) << shift;
+      if (b < 0x80) break;
+    }
+    return (int) x;
+  }
+  auto string () -> std::string {
+    int length = varint();
+    pos_ += length;
+    return std::string(buf_.substr(pos_ - length, length));
+  }
+ private:
+  std::string_view buf_;
+  size_t pos_ = 0;
+};
+
+// most entries are just an id.
+template <typename Log>
+auto encode (Encoder &encoder, const Log &log) -> void {
+  encoder.varint(log.id);
+}
+template <typename Log>
+auto decode (Decoder &decoder, Log &log) -> void {
+  log.id = decoder.varint();
+}
+auto encode (Encoder &encoder, const rollback::RefundTicket &log)
+  -> void {
+  encoder.varint(log.id);
+  encoder.varint(log.status);
+}
+auto decode (Decoder &decoder, rollback::RefundTicket &log)
+  -> void {
+  log.id = decoder.varint();
+  log.status = (Order::Status) decoder.varint();
+}
+auto encode (Encoder &encoder, const rollback::ModifyProfile &log)
+  -> void {
+  encoder.varint(log.id);
+  encoder.byte((log.password ? 1 : 0) | (log.name ? 2 : 0) |
+    (log.email ? 4 : 0) | (log.privilege ? 8 : 0));
+  if (log.password) encoder.string(log.password->str());
+  if (log.name) encoder.string(log.name->str());
+  if (log.email) encoder.string(log.email->str());
+  if (log.privilege) encoder.varint(*log.privilege);
+}
+auto decode (Decoder &decoder, rollback::ModifyProfile &log)
+  -> void {
+  log.id = decoder.varint();
+  int fields = decoder.byte();
+  if (fields & 1) log.password = User::Password(decoder.string());
+  if (fields & 2) log.name = User::Name(decoder.string());
+  if (fields & 4) log.email = User::Email(decoder.string());
+  if (fields & 8) log.privilege = decoder.varint();
+}
+
+template <typename Content>
+struct ContentDecoder;
+template <typename ...Ts>
+struct ContentDecoder<Variant<Ts...>> {
+  /// decodes the content of the tag-th type.
+  static auto decode (Decoder &decoder, int tag) -> Variant<Ts...> {
+    Variant<Ts...> content;
+    int ix = 0;
+    ((ix++ == tag ? (void) (content = decodeAs_<Ts>(decoder))
+      : (void) 0), ...);
+    TICKET_ASSERT(content.index() == tag);
+    return content;
+  }
+ private:
+  template <typename T>
+  static auto decodeAs_ (Decoder &decoder) -> T {
+    T log;
+    ::ticket::decode(decoder, log);
+    return log;
+  }
+};
+
+/// the log, with the newest entry at the end.
+file::AppendLog entries {"rollback.log"};
+
+auto readEntry (std::string_view record) -> rollback::LogEntry {
+  Decoder decoder(record);
+  rollback::LogEntry entry;
+  int tag = decoder.byte();
+  entry.timestamp = decoder.varint();
+  entry.content = ContentDecoder<rollback::LogEntry::Content>
+    ::decode(decoder, tag);
+  return entry;
+}
+/// gets the id of the last log entry, -1 if there is none.
+auto lastLogId () -> int { return (int) entries.size() - 1; }
+
+/**
+ * @brief A consistent snapshot of all the files.
+ *
+ * It is the state right after the command at timestamp,
+ * when the last log entry was lastLogId, ending at logEnd.
+ */
+struct Checkpoint {
+  int epoch;
+  int timestamp;
+  int lastLogId;
+  size_t logEnd;
+};
+/// a checkpoint is taken after this many log entries.
+constexpr int kCheckpointInterval = 4096;
+constexpr const char *kCheckpointFilename = "checkpoints";
+
+Vector<Checkpoint> checkpoints;
+bool checkpointsLoaded = false;
+/// log entries since the last checkpoint.
+int logsSinceCheckpoint = 0;
+/// see rollback::setRetention.
+int retention = -1;
+
+auto saveCheckpoints () -> void {
+  std::ofstream file(kCheckpointFilename, std::ios::binary);
+  for (const auto &checkpoint : checkpoints) {
+    file.write((const char *) &checkpoint, sizeof(checkpoint));
+  }
+}
+auto loadCheckpoints () -> void {
+  if (checkpointsLoaded) return;
+  checkpointsLoaded = true;
+  std::ifstream file(kCheckpointFilename, std::ios::binary);
+  Checkpoint checkpoint;
+  while (file.read((char *) &checkpoint, sizeof(checkpoint))) {
+    checkpoints.push_back(checkpoint);
+  }
+  if (checkpoints.empty()) {
+    logsSinceCheckpoint = lastLogId() + 1;
+  } else {
+    logsSinceCheckpoint = lastLogId() - checkpoints.back().lastLogId;
+    file::checkpoint::begin(checkpoints.back().epoch);
+  }
+}
+/// drops the checkpoints from checkpoints[ix] on.
+auto dropCheckpoints (int ix, bool restore) -> void {
+  if (ix == checkpoints.size()) return;
+  int epoch = checkpoints[ix].epoch;
+  if (restore) {
+    // the log is not paged, and is truncated instead.
+    file::checkpoint::restore(epoch);
+    entries.truncate(
+      checkpoints[ix].lastLogId + 1, checkpoints[ix].logEnd);
+  } else {
+    file::checkpoint::drop(epoch);
+  }
+  // with none left, the epochs start over from 0, and the
+  // old journal records must not be taken as theirs.
+  if (ix == 0) {
+    file::checkpoint::forget(epoch);
+    file::checkpoint::begin(0);
+  }
+  while (checkpoints.size() > ix) checkpoints.pop_back();
+  saveCheckpoints();
+}
+
+/**
+ * @brief discards what no rollback may reach, i.e. what is
+ * needed only for targets before horizon.
+ */
+auto forgetBefore (int horizon) -> void {
+  // the checkpoint restored is at or after the target, so
+  // the ones before the horizon are dead. the last one is
+  // kept for the log entries after it.
+  size_t dead = 0;
+  while (dead + 1 < checkpoints.size() &&
+         checkpoints[dead].timestamp < horizon) {
+    ++dead;
+  }
+  if (dead > 0) {
+    Vector<Checkpoint> rest;
+    for (size_t i = dead; i < checkpoints.size(); ++i) {
+      rest.push_back(checkpoints[i]);
+    }
+    checkpoints = rest;
+    saveCheckpoints();
+    file::checkpoint::forget(checkpoints[0].epoch);
+  }
+  // the entries at or before the target are never undone.
+  entries.forget(horizon);
+}
+
+/// undoes a log entry. order entries are buffered in undo,
+/// and the others are run on the files as they are.
+template <typename Log>
+auto runUndo (const Log &log, rollback::OrderUndo &undo)
+  -> Result<Unit, Exception> {
+  if constexpr (requires { rollback::run(log, undo); }) {
+    return rollback::run(log, undo);
+  } else {
+    undo.flush();
+    return rollback::run(log);
+  }
+}
+
+} // namespace
+
 static int currentTime;
+static bool hasCurrentTime = false;
 auto setTimestamp (int timestamp) -> void {
+  loadCheckpoints();
+  // the previous command is complete here, so this is a
+  // consistent state. the state after the previous run of
+  // the program has no known timestamp, though.
+  if (hasCurrentTime && logsSinceCheckpoint >= kCheckpointInterval) {
+    int epoch = checkpoints.empty() ? 1 : checkpoints.back().epoch + 1;
+    checkpoints.push_back({
+      epoch,
+      currentTime,
+      lastLogId(),
+      entries.end(),
+    });
+    saveCheckpoints();
+    file::checkpoint::begin(epoch);
+    logsSinceCheckpoint = 0;
+    if (retention >= 0) forgetBefore(currentTime - retention);
+  }
   currentTime = timestamp;
+  hasCurrentTime = true;
 }
 
 auto rollback::log (
   const rollback::LogEntry::Content &content) -> void {
-  rollback::LogEntry entry;
-  entry.timestamp = currentTime;
-  entry.content = content;
-  entry.save();
-  rollback::LogEntry::file.setMeta({ entry.id() });
+  Encoder encoder;
+  encoder.byte(content.index());
+  encoder.varint(currentTime);
+  content.visit([&encoder] (const auto &log) {
+    encode(encoder, log);
+  });
+  entries.push(encoder.data(), encoder.length(), currentTime);
+  ++logsSinceCheckpoint;
+}
+
+auto rollback::clearLog () -> void {
+  loadCheckpoints();
+  dropCheckpoints(0, false);
+  entries.clear();
+  logsSinceCheckpoint = 0;
+}
+
+auto rollback::setRetention (int window) -> void {
+  retention = window;
 }
 
 auto command::run (const command::Rollback &cmd)
@@ -25,24 +307,57 @@ auto command::run (const command::Rollback &cmd)
   if (cmd.timestamp > currentTime) {
     return Exception("rollback target is in the future");
   }
+  if (retention >= 0 && cmd.timestamp < currentTime - retention) {
+    return Exception("rollback target is beyond the retention horizon");
+  }
 
   User::clearSessions();
+  loadCheckpoints();
+
+  // restoring the earliest checkpoint at or after the target
+  // leaves only a short tail of the log to undo. it is not
+  // worth it if the tail is short anyway.
+  int lastId = lastLogId();
+  int ixFuture = checkpoints.size();
+  while (ixFuture > 0 &&
+         checkpoints[ixFuture - 1].timestamp > cmd.timestamp) {
+    --ixFuture;
+  }
+  int ixCheckpoint = ixFuture;
+  if (ixCheckpoint > 0 &&
+      checkpoints[ixCheckpoint - 1].timestamp == cmd.timestamp) {
+    --ixCheckpoint;
+  }
+  bool restore = ixCheckpoint < checkpoints.size() &&
+    lastId - checkpoints[ixCheckpoint].lastLogId >=
+      kCheckpointInterval / 2;
+  if (restore) {
+    lastId = checkpoints[ixCheckpoint].lastLogId;
+    journey::invalidate();
+    dropCheckpoints(ixCheckpoint, true);
+  } else {
+    // the later checkpoints are in the future after rollback.
+    dropCheckpoints(ixFuture, false);
+  }
+  TICKET_ASSERT(lastId == lastLogId());
 
-  int lastId = rollback::LogEntry::file.getMeta().id;
-  while (lastId >= 0) {
-    auto entry = rollback::LogEntry::get(lastId);
+  rollback::OrderUndo undo;
+  while (!entries.empty()) {
+    auto entry = readEntry(entries.back());
     if (entry.timestamp <= cmd.timestamp) break;
-    --lastId;
-    entry.content.visit([] (const auto &cmd) {
-      auto res = rollback::run(cmd);
+    entries.pop();
+    entry.content.visit([&undo] (const auto &cmd) {
+      auto res = runUndo(cmd, undo);
       if (auto err = res.error()) {
         // There must be something going unwildly wrong.
         throw *err;
       }
     });
-    entry.destroy();
   }
-  rollback::LogEntry::file.setMeta({ lastId });
+  undo.flush();
+  logsSinceCheckpoint = checkpoints.empty()
+    ? lastLogId() + 1
+    : lastLogId() - checkpoints.back().lastLogId;
   return unit;
 }
 
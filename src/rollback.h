@@ -1,13 +1,14 @@
 #ifndef TICKET_BACKLOG_H_
 #define TICKET_BACKLOG_H_
 
-#include "file/file.h"
+#include "hashmap.h"
 #include "optional.h"
 #include "order.h"
 #include "result.h"
 #include "train.h"
 #include "user.h"
 #include "variant.h"
+#include "vector.h"
 
 namespace ticket {
 /// sets the current timestamp.
@@ -55,7 +56,7 @@ struct FulfillOrder {
   int id;
 };
 
-struct LogEntryBase {
+struct LogEntry {
   using Content = Variant<
     AddUser,
     ModifyProfile,
@@ -69,31 +70,80 @@ struct LogEntryBase {
 
   int timestamp;
   Content content;
-
-  static constexpr const char *filename = "rollback-log";
-};
-struct LastEntry {
-  int id = -1;
 };
-using LogEntry = file::Managed<LogEntryBase, LastEntry>;
 
 /// inserts a log entry.
 auto log (const LogEntry::Content &content) -> void;
+/// drops all log entries and checkpoints. used by the clean
+/// command.
+auto clearLog () -> void;
+/**
+ * @brief keeps only window of history for rollbacks.
+ *
+ * a rollback to earlier than window before the current
+ * timestamp is rejected, so the log entries and the
+ * checkpoints before that are discarded as time goes on. a
+ * negative window, the default, keeps everything.
+ */
+auto setRetention (int window) -> void;
+
+/**
+ * @brief Buffered effects of undoing the order entries.
+ *
+ * Undoing many orders on a hot ride would read and write
+ * the ride once per entry. Instead, the orders and rides
+ * are cached here, the changes to the pending queues and
+ * the user index are kept as net sets, and all of them are
+ * written once, in page order, on flush().
+ */
+class OrderUndo {
+ public:
+  /// gets an order with the buffered changes applied.
+  auto order (int id) -> const Order &;
+  /// changes the status of an order.
+  auto setStatus (int id, Order::Status status) -> void;
+  /// gets the seats of a ride for modification.
+  auto seats (const Ride &ride) -> RideSeats &;
+  /// inserts an order into its pending queue.
+  auto enqueue (const Order &order) -> void;
+  /// removes an order from its pending queue.
+  auto dequeue (const Order &order) -> void;
+  /// removes an order from the index of its user.
+  auto removeFromUser (const Order &order) -> void;
+  /// writes all the buffered changes.
+  auto flush () -> void;
+
+ private:
+  struct CachedOrder {
+    Order order;
+    bool dirty = false;
+  };
+  HashMap<int, CachedOrder> orders_;
+  /// seats keyed by the train and the date of the ride.
+  HashMap<long long, RideSeats> rides_;
+  /// net insertions into the pending queues, by order id.
+  HashMap<int, int> pending_;
+  Vector<int> removedFromUser_;
+};
 
 /**
  * @brief Visitor for the log entries.
  *
  * The implementations are in the corresponding source
- * files, not in rollback.cpp.
+ * files, not in rollback.cpp. The order entries are
+ * buffered in an OrderUndo.
  */
 auto run (const AddUser &log) -> Result<Unit, Exception>;
 auto run (const ModifyProfile &log) -> Result<Unit, Exception>;
 auto run (const AddTrain &log) -> Result<Unit, Exception>;
 auto run (const DeleteTrain &log) -> Result<Unit, Exception>;
 auto run (const ReleaseTrain &log) -> Result<Unit, Exception>;
-auto run (const BuyTicket &log) -> Result<Unit, Exception>;
-auto run (const RefundTicket &log) -> Result<Unit, Exception>;
-auto run (const FulfillOrder &log) -> Result<Unit, Exception>;
+auto run (const BuyTicket &log, OrderUndo &undo)
+  -> Result<Unit, Exception>;
+auto run (const RefundTicket &log, OrderUndo &undo)
+  -> Result<Unit, Exception>;
+auto run (const FulfillOrder &log, OrderUndo &undo)
+  -> Result<Unit, Exception>;
 
 } // namespace ticket::rollback
 
@@ -30,7 +30,9 @@ auto run (const ReleaseTrain &cmd) -> Result<Response, Exception>;
 auto run (const QueryTrain &cmd) -> Result<Response, Exception>;
 auto run (const QueryTicket &cmd) -> Result<Response, Exception>;
 auto run (const QueryTransfer &cmd) -> Result<Response, Exception>;
+auto run (const QueryJourney &cmd) -> Result<Response, Exception>;
 auto run (const BuyTicket &cmd) -> Result<Response, Exception>;
+auto run (const BuyTickets &cmd) -> Result<Response, Exception>;
 auto run (const QueryOrder &cmd) -> Result<Response, Exception>;
 auto run (const RefundTicket &cmd) -> Result<Response, Exception>;
 auto run (const Rollback &cmd) -> Result<Response, Exception>;
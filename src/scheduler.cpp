@@ -0,0 +1,96 @@
+#include "scheduler.h"
+
+#include <signal.h>
+
+#include "response.h"
+
+namespace ticket {
+
+Scheduler::Scheduler (int threads, Protocol protocol)
+  : threads_(threads > 0 ? threads : 0), protocol_(protocol),
+    workers_(new std::thread[threads_]) {
+  for (int i = 0; i < threads_; ++i) {
+    workers_[i] = std::thread([this] { work_(); });
+  }
+}
+
+Scheduler::~Scheduler () {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  started_.fetch_add(1, std::memory_order_release);
+  started_.notify_all();
+  for (int i = 0; i < threads_; ++i) workers_[i].join();
+  delete[] workers_;
+}
+
+auto Scheduler::runReads (Frame *const *frames, size_t n) -> void {
+  if (threads_ == 0 || n == 1) {
+    for (size_t i = 0; i < n; ++i) runFrame_(*frames[i]);
+    return;
+  }
+  uint32_t batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch = ++batch_;
+    frames_ = frames;
+    count_ = n;
+  }
+  done_.store(0, std::memory_order_relaxed);
+  next_.store((uint64_t) batch << 32, std::memory_order_release);
+  started_.store(batch, std::memory_order_release);
+  started_.notify_all();
+  runBatch_(batch, frames, n);
+  while (true) {
+    auto done = done_.load(std::memory_order_acquire);
+    if (done == n) break;
+    done_.wait(done, std::memory_order_acquire);
+  }
+}
+
+auto Scheduler::work_ () -> void {
+  // the signals go to the main thread, see serve().
+  sigset_t mask;
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  uint32_t seen = 0;
+  while (true) {
+    started_.wait(seen, std::memory_order_acquire);
+    Frame *const *frames;
+    size_t count;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) return;
+      seen = batch_;
+      frames = frames_;
+      count = count_;
+    }
+    runBatch_(seen, frames, count);
+  }
+}
+
+auto Scheduler::runBatch_ (
+  uint32_t batch, Frame *const *frames, size_t count) -> void {
+  while (true) {
+    auto next = next_.load(std::memory_order_acquire);
+    do {
+      if ((next >> 32) != batch || (uint32_t) next >= count) return;
+    } while (!next_.compare_exchange_weak(next, next + 1,
+      std::memory_order_acq_rel));
+    runFrame_(*frames[(uint32_t) next]);
+    if (done_.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+      done_.notify_one();
+    }
+  }
+}
+
+auto Scheduler::runFrame_ (Frame &frame) const -> void {
+  auto &out = response::out;
+  frame.reply.clear();
+  out.capture(&frame.reply);
+  execute(protocol_, frame.cmd);
+  out.capture(nullptr);
+}
+
+} // namespace ticket
@@ -0,0 +1,75 @@
+// This file runs the queries concurrently.
+#ifndef TICKET_SCHEDULER_H_
+#define TICKET_SCHEDULER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "protocol.h"
+
+namespace ticket {
+
+/**
+ * @brief Runs batches of read-only commands on a pool of
+ * threads.
+ *
+ * The caller runs the writes itself, one at a time and in
+ * order, and hands the runs of queries in between to
+ * runReads(). A batch only starts after the write before it
+ * and ends before the write after it, so all of its queries
+ * see the same state. The storage allows concurrent reads,
+ * see File::get().
+ *
+ * The caller takes part in every batch, so a batch of one
+ * query, or a pool of no threads, runs on it alone.
+ */
+class Scheduler {
+ public:
+  /**
+   * @param threads the number of threads besides the caller.
+   * @param protocol the format of the responses.
+   */
+  Scheduler (int threads, Protocol protocol);
+  Scheduler (const Scheduler &) = delete;
+  auto operator= (const Scheduler &) -> Scheduler & = delete;
+  ~Scheduler ();
+
+  /**
+   * @brief runs the queries of the n frames, writing each
+   * response into frame.reply.
+   *
+   * the timestamps are up to the caller.
+   */
+  auto runReads (Frame *const *frames, size_t n) -> void;
+
+ private:
+  int threads_;
+  Protocol protocol_;
+  std::thread *workers_;
+  /// the batch, guarded by mutex_.
+  std::mutex mutex_;
+  Frame *const *frames_ = nullptr;
+  size_t count_ = 0;
+  uint32_t batch_ = 0;
+  bool stopping_ = false;
+  /// the last batch started, which the workers wait on.
+  std::atomic<uint32_t> started_ = 0;
+  /// the batch in the high bits, and the next frame to run
+  /// in the low ones, so that a late worker claims nothing
+  /// from a later batch.
+  std::atomic<uint64_t> next_ = 0;
+  /// the number of frames of the batch run.
+  std::atomic<size_t> done_ = 0;
+
+  auto work_ () -> void;
+  /// runs the frames of the batch until none is left.
+  auto runBatch_ (uint32_t batch, Frame *const *frames, size_t count)
+    -> void;
+  auto runFrame_ (Frame &frame) const -> void;
+};
+
+} // namespace ticket
+
+#endif // TICKET_SCHEDULER_H_
@@ -0,0 +1,357 @@
+#include "server.h"
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "response.h"
+#include "rollback.h"
+#include "scheduler.h"
+#include "utility.h"
+#include "vector.h"
+
+namespace ticket {
+
+namespace {
+
+/// a connection to a client.
+struct Client {
+  int fd;
+  /// the index in Server::clients_.
+  size_t ix;
+  /// the bytes received but not run yet.
+  std::string in;
+  /// the bytes of replies not sent yet.
+  std::string out;
+  /// the client sent all it had.
+  bool eof = false;
+  /// no more lines are run, and the connection is closed
+  /// once out is sent.
+  bool closing = false;
+  /// it is in Server::touched_.
+  bool touched = false;
+};
+
+class Server {
+ public:
+  Server (Protocol protocol, Scheduler &scheduler)
+    : protocol_(protocol), scheduler_(scheduler) {}
+  Server (const Server &) = delete;
+  auto operator= (const Server &) -> Server & = delete;
+  ~Server () {
+    for (auto *client : clients_) {
+      close(client->fd);
+      delete client;
+    }
+    for (auto *client : dead_) delete client;
+    for (auto *frame : frames_) delete frame;
+    if (epoll_ >= 0) close(epoll_);
+    if (signals_ >= 0) close(signals_);
+    if (listener_ >= 0) {
+      close(listener_);
+      unlink(path_.c_str());
+    }
+  }
+
+  auto run (const char *path) -> int {
+    path_ = path;
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path_.length() >= sizeof(addr.sun_path)) {
+      std::cerr << "Socket path too long: " << path << std::endl;
+      return 1;
+    }
+    memcpy(addr.sun_path, path, path_.length());
+    listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    // a socket left behind by an earlier run.
+    unlink(path);
+    if (listener_ < 0
+      || bind(listener_, (const sockaddr *) &addr, sizeof(addr)) < 0
+      || listen(listener_, SOMAXCONN) < 0) {
+      return fail_("Unable to listen on socket");
+    }
+
+    // the signals are read from a descriptor, so that the
+    // loop stops between two commands.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    signals_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    if (signals_ < 0 || epoll_ < 0) return fail_("Unable to poll");
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &listener_;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, listener_, &ev);
+    ev.data.ptr = &signals_;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, signals_, &ev);
+
+    epoll_event events[kEvents];
+    while (true) {
+      // lines left over from the last round do not wait.
+      auto n = epoll_wait(epoll_, events, kEvents,
+        touched_.empty() ? -1 : 0);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return fail_("Unable to poll");
+      }
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.ptr == &signals_) return 0;
+        if (events[i].data.ptr == &listener_) {
+          accept_();
+          continue;
+        }
+        auto *client = (Client *) events[i].data.ptr;
+        if ((events[i].events & EPOLLOUT) != 0 && !send_(client)) {
+          continue;
+        }
+        if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+          receive_(client);
+        }
+        touch_(client);
+      }
+      runRound_();
+    }
+  }
+
+ private:
+  static constexpr int kEvents = 64;
+  static constexpr size_t kBlock = 1 << 16;
+  /// the longest request a client may send.
+  static constexpr size_t kMaxLine = 1 << 20;
+  /// the replies a client may leave unread before its
+  /// lines stop being run.
+  static constexpr size_t kMaxPending = 1 << 20;
+  /// the most requests run in a round.
+  static constexpr size_t kRound = 256;
+  Protocol protocol_;
+  Scheduler &scheduler_;
+  std::string path_;
+  int listener_ = -1;
+  int signals_ = -1;
+  int epoll_ = -1;
+  Vector<Client *> clients_;
+  /// the clients that may have lines to run or replies to
+  /// send.
+  Vector<Client *> touched_;
+  /// the frames of the round, kept to reuse their buffers,
+  /// and the clients they come from.
+  Vector<Frame *> frames_;
+  Vector<Client *> owners_;
+  /// the clients dropped in the round.
+  Vector<Client *> dead_;
+
+  auto fail_ (const char *message) -> int {
+    std::cerr << message << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+
+  auto accept_ () -> void {
+    while (true) {
+      int fd = accept4(listener_, nullptr, nullptr,
+        SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) return;
+      auto *client = new Client { fd, clients_.size() };
+      clients_.push_back(client);
+      epoll_event ev {};
+      ev.events = EPOLLIN;
+      ev.data.ptr = client;
+      epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev);
+    }
+  }
+  /// closes the connection. the client is deleted at the
+  /// end of the round, as touched_ may still point to it.
+  auto drop_ (Client *client) -> void {
+    epoll_ctl(epoll_, EPOLL_CTL_DEL, client->fd, nullptr);
+    close(client->fd);
+    client->fd = -1;
+    auto *last = clients_[clients_.size() - 1];
+    last->ix = client->ix;
+    clients_[client->ix] = last;
+    clients_.pop_back();
+    dead_.push_back(client);
+  }
+  auto touch_ (Client *client) -> void {
+    if (client->touched) return;
+    client->touched = true;
+    touched_.push_back(client);
+  }
+
+  /// reads what the client sent.
+  auto receive_ (Client *client) -> void {
+    char buf[kBlock];
+    while (true) {
+      auto n = read(client->fd, buf, kBlock);
+      if (n > 0) {
+        client->in.append(buf, n);
+        if ((size_t) n < kBlock) break;
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      // an error is taken as the end of the input.
+      client->eof = n == 0 || errno != EAGAIN;
+      break;
+    }
+    // the last line may have no newline, while a partial
+    // binary frame is dropped.
+    if (client->eof && !client->in.empty()) {
+      if (protocol_ == Protocol::kBinary) {
+        std::string_view body;
+        if (splitFrame(protocol_, client->in, body) == 0) client->in.clear();
+      } else if (client->in.back() != '\n') {
+        client->in += '\n';
+      }
+    }
+  }
+
+  /**
+   * @brief runs the lines of the touched clients, and sends
+   * the replies.
+   *
+   * the lines are taken client by client, in order. The
+   * runs of queries among them go to the scheduler, and the
+   * other commands run here, one at a time.
+   */
+  auto runRound_ () -> void {
+    size_t n = 0;
+    for (auto *client : touched_) n = takeLines_(client, n);
+
+    size_t begin = 0;
+    for (size_t i = 0; i <= n; ++i) {
+      if (i < n && isRead_(*frames_[i])) continue;
+      // the queries before frame i.
+      if (i > begin) {
+        for (size_t j = begin; j < i; ++j) {
+          setTimestamp(frames_[j]->timestamp);
+        }
+        scheduler_.runReads(&frames_[begin], i - begin);
+      }
+      if (i < n) runOther_(owners_[i], *frames_[i]);
+      begin = i + 1;
+    }
+
+    auto &out = response::out;
+    for (size_t i = 0; i < n; ++i) {
+      out.capture(&owners_[i]->out);
+      writeReply(protocol_, *frames_[i]);
+      out.capture(nullptr);
+    }
+
+    // the clients with lines left stay touched.
+    Vector<Client *> touched;
+    for (auto *client : touched_) {
+      client->touched = false;
+      if (client->fd < 0) continue;
+      if (client->eof && client->in.empty()) client->closing = true;
+      if (!send_(client)) continue;
+      if (hasLine_(client)) {
+        client->touched = true;
+        touched.push_back(client);
+      }
+    }
+    touched_ = touched;
+    for (auto *client : dead_) delete client;
+    dead_.clear();
+  }
+  /// checks if the client has a request to run now.
+  auto hasLine_ (const Client *client) const -> bool {
+    std::string_view body;
+    return !client->closing && client->out.length() < kMaxPending
+      && splitFrame(protocol_, client->in, body) != 0;
+  }
+  /// parses the requests of the client into frames from n on.
+  auto takeLines_ (Client *client, size_t n) -> size_t {
+    if (client->fd < 0) return n;
+    size_t begin = 0;
+    while (n < kRound && !client->closing
+      && client->out.length() < kMaxPending) {
+      std::string_view body;
+      auto length = splitFrame(protocol_,
+        std::string_view(client->in).substr(begin), body);
+      if (length == 0) break;
+      begin += length;
+      if (protocol_ == Protocol::kText && body.empty()) continue;
+      if (n == frames_.size()) {
+        frames_.push_back(new Frame);
+        owners_.push_back(nullptr);
+      }
+      auto &frame = *frames_[n];
+      readFrame(protocol_, body, frame);
+      owners_[n++] = client;
+      // nothing after a failed parse or an exit is run.
+      if (!frame.parsed || frame.cmd.is<command::Exit>()) {
+        client->closing = true;
+      }
+    }
+    client->in.erase(0, begin);
+    if (client->in.length() > kMaxLine) client->closing = true;
+    return n;
+  }
+  static auto isRead_ (const Frame &frame) -> bool {
+    return frame.parsed && command::isReadOnly(frame.cmd);
+  }
+  /// runs a frame which is not a query.
+  auto runOther_ (Client *client, Frame &frame) -> void {
+    auto &out = response::out;
+    frame.reply.clear();
+    out.capture(&frame.reply);
+    if (!frame.parsed) {
+      writeParseError(protocol_);
+    } else if (frame.cmd.is<command::Exit>()) {
+      writeBye(protocol_);
+    } else {
+      setTimestamp(frame.timestamp);
+      execute(protocol_, frame.cmd);
+    }
+    out.capture(nullptr);
+  }
+
+  /// sends the pending replies, closing the client once all
+  /// is sent if it is closing. false if it is closed.
+  auto send_ (Client *client) -> bool {
+    size_t sent = 0;
+    while (sent < client->out.length()) {
+      auto n = ::send(client->fd, client->out.data() + sent,
+        client->out.length() - sent, MSG_NOSIGNAL);
+      if (n > 0) {
+        sent += n;
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && errno == EAGAIN) break;
+      // the client is gone.
+      drop_(client);
+      return false;
+    }
+    client->out.erase(0, sent);
+    if (client->out.empty() && client->closing) {
+      drop_(client);
+      return false;
+    }
+    epoll_event ev {};
+    ev.events = client->out.empty() ? EPOLLIN : EPOLLOUT;
+    ev.data.ptr = client;
+    epoll_ctl(epoll_, EPOLL_CTL_MOD, client->fd, &ev);
+    return true;
+  }
+};
+
+} // namespace
+
+auto serve (const char *path, Protocol protocol, Scheduler &scheduler)
+  -> int {
+  Server server(protocol, scheduler);
+  return server.run(path);
+}
+
+} // namespace ticket
@@ -0,0 +1,32 @@
+// This file serves the commands over a Unix domain socket.
+#ifndef TICKET_SERVER_H_
+#define TICKET_SERVER_H_
+
+#include "protocol.h"
+
+namespace ticket {
+
+class Scheduler;
+
+/**
+ * @brief serves clients on the socket at path until SIGINT
+ * or SIGTERM.
+ *
+ * Every client sends requests in the given protocol and
+ * gets the same responses as over stdin. All clients
+ * share one timeline. Their commands are taken in the
+ * order they arrive, and the writes run one at a time on
+ * this thread, while the runs of queries in between go to
+ * the scheduler. A request failing to parse gets an error
+ * and ends the session, and the exit command gets bye and
+ * ends the session, the engine keeping on serving the
+ * others.
+ *
+ * @return the exit code of the program.
+ */
+auto serve (const char *path, Protocol protocol, Scheduler &scheduler)
+  -> int;
+
+} // namespace ticket
+
+#endif // TICKET_SERVER_H_
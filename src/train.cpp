@@ -1,8 +1,10 @@
 #include "train.h"
 
+#include "allocator.h"
 #include "datetime.h"
 #include "exception.h"
 #include "hashmap.h"
+#include "journey.h"
 #include "map.h"
 #include "parser.h"
 #include "priority-queue.h"
@@ -22,22 +24,13 @@ file::Index<Ride, RideSeats> RideSeats::ixRide
   {&RideSeats::ride, "ride-seats.ride.ix"};
 
 // TODO(perf): inline these methods
-auto Train::indexOfStop (const std::string &name) const
+auto Train::indexOfStop (std::string_view name) const
   -> Optional<int> {
   for (int i = 0; i < stops.length; ++i) {
-    // TODO(perf): eliminate this string copy
-    if (stops[i].str() == name) return i;
+    if (stops[i].view() == name) return i;
   }
   return unit;
 }
-auto Train::totalPrice (int ixFrom, int ixTo) const -> int {
-  TICKET_ASSERT(ixFrom < ixTo);
-  int price = 0;
-  for (int i = ixFrom; i < ixTo; ++i) {
-    price += edges[i].price;
-  }
-  return price;
-}
 auto Train::getRide (Date date) const
   -> Optional<RideSeats> {
   return RideSeats::ixRide.findOne({id(), date});
@@ -86,8 +79,10 @@ auto command::run (const command::AddTrain &cmd)
 
   for(const auto & s : cmd.stations) train.stops.push(s);
   Instant ins = cmd.departure;
+  train.prices.push(0);
   for(int i = 0; i + 1 < cmd.stations.size(); ++ i){
     train.edges.push( {cmd.prices[i], ins, ins + cmd.durations[i]} );
+    train.prices.push(train.prices[i] + cmd.prices[i]);
     ins = ins + cmd.durations[i];
     if(i + 2 < cmd.stations.size()) ins = ins + cmd.stopoverTimes[i];
   }
@@ -140,6 +135,7 @@ auto command::run (const command::ReleaseTrain &cmd)
     RideSeats :: ixRide.insert(rd);
   }
 
+  journey::addTrain(*tr);
   rollback::log(rollback::ReleaseTrain { tr->id() });
 
   return unit;
@@ -168,9 +164,12 @@ auto command::run (const command::QueryTrain &cmd)
 }
 auto command::run (const command::QueryTicket &cmd)
   -> Result<Response, Exception> {
-  Vector<Range> vct;
-  auto v_from = Train::ixStop.findMany( std::hash<std::string>()(cmd.from) );
-  auto v_to = Train::ixStop.findMany( std::hash<std::string>()(cmd.to) );
+  // the candidates live in the arena, and only the page is
+  // copied out.
+  Arena::Scope arena;
+  ArenaVector<Range> vct;
+  auto v_from = Train::ixStop.findMany( std::hash<std::string_view>()(cmd.from) );
+  auto v_to = Train::ixStop.findMany( std::hash<std::string_view>()(cmd.to) );
 
   for(auto ele: v_to)
     v_from.push_back(ele);
@@ -185,18 +184,25 @@ auto command::run (const command::QueryTicket &cmd)
       auto ixTo = train.indexOfStop(cmd.to);
 
       if( !ixFrom || !ixTo || *ixFrom > *ixTo ) continue;
-      auto rd = train.getRide( cmd.date, *ixFrom);
-      if( ! rd ) continue;
-
-      long long totPrice = train.totalPrice(*ixFrom, *ixTo);
-      auto seats = rd->ticketsAvailable(*ixFrom, *ixTo);
-
-      vct.push_back( ticket::Range( *rd, *ixFrom, *ixTo,
-        totPrice, train.edges[*ixTo - 1].arrival
-          - train.edges[*ixFrom].departure, seats, train.trainId ) );
+      // a released train has a ride on every date it runs,
+      // so the ride itself is only fetched for the ranges
+      // on the requested page.
+      Date start =
+        cmd.date - train.edges[*ixFrom].departure.daysOverflow();
+      if( !start.inRange(train.begin, train.end) ) continue;
+
+      RideSeats rd;
+      rd.ride = { train.id(), start };
+      vct.push_back( ticket::Range( rd, *ixFrom, *ixTo,
+        train.totalPrice(*ixFrom, *ixTo),
+        train.duration(*ixFrom, *ixTo), 0, train.trainId ) );
     }
 
-  sort( vct.begin(), vct.end(), Cmp(
+  int begin = std::min(std::max(cmd.offset, 0), (int) vct.size());
+  int end = cmd.limit
+    ? std::min(begin + std::max(*cmd.limit, 0), (int) vct.size())
+    : (int) vct.size();
+  auto cmp = Cmp(
     [&cmd] (const Range &r1, const Range &r2) {
       if( cmd.sort == command::kTime){
         if( r1.time != r2.time) return  r1.time < r2.time;
@@ -207,52 +213,87 @@ auto command::run (const command::QueryTicket &cmd)
         return  r1.totalPrice < r2.totalPrice;
       return r1.trainId.str() < r2.trainId.str();
     }
-  )
   );
-  return vct;
+  if (cmd.limit) {
+    partialSort(vct.begin(), vct.begin() + end, vct.end(), cmp);
+  } else {
+    sort(vct.begin(), vct.end(), cmp);
+  }
+
+  Vector<Range> page;
+  page.reserve(end - begin);
+  for (int i = begin; i < end; ++i) {
+    auto &range = vct[i];
+    range.rd = *RideSeats::ixRide.findOne(range.rd.ride);
+    range.seats = range.rd.ticketsAvailable(range.ixFrom, range.ixTo);
+    page.push_back(range);
+  }
+  return page;
 }
 
 
-struct SectionCmp {
-  using Pair = std::pair<Section, Section *>;
+/**
+ * @brief A section in the queue of a station, with the
+ * arrival it had when pushed.
+ *
+ * move_to_tomorrow() pushes the section again rather than
+ * updating it in the queue, and the entries left behind are
+ * told apart by their arrival.
+ */
+struct Candidate {
+  Instant Arrival;
+  long long totalPrice;
+  Section *section;
+
+  Candidate (Section &section)
+    : Arrival(section.Arrival), totalPrice(section.totalPrice),
+      section(&section) {}
+  /// checks if the section has not moved since.
+  auto current () const -> bool { return section->Arrival == Arrival; }
+};
+
+struct CandidateCmp {
   command::SortType type;
-  auto operator() (const Pair &lhs, const Pair &rhs) const
+  auto operator() (const Candidate &lhs, const Candidate &rhs) const
     -> bool {
     //  cmd.sort == kTime: smaller section.Departure, section.totalPrice, section.trainID
     //  cmd.sort == kCost: smaller section.totalPrice, section.Departure, section.trainID
     if (type == command::kCost) {
-      if (lhs.first.totalPrice != rhs.first.totalPrice) {
-        return lhs.first.totalPrice > rhs.first.totalPrice;
+      if (lhs.totalPrice != rhs.totalPrice) {
+        return lhs.totalPrice > rhs.totalPrice;
       }
     }
-    if (lhs.first.Arrival != rhs.first.Arrival) {
-      return lhs.first.Arrival > rhs.first.Arrival;
+    if (lhs.Arrival != rhs.Arrival) {
+      return lhs.Arrival > rhs.Arrival;
     }
     if (type == command::kTime) {
-      if (lhs.first.totalPrice != rhs.first.totalPrice) {
-        return lhs.first.totalPrice > rhs.first.totalPrice;
+      if (lhs.totalPrice != rhs.totalPrice) {
+        return lhs.totalPrice > rhs.totalPrice;
       }
     }
-    return lhs.first.trainId.str() > rhs.first.trainId.str();
+    return lhs.section->trainId.view() > rhs.section->trainId.view();
   }
 };
 
-command::SortType Sol::sort;
+thread_local command::SortType Sol::sort;
 auto command::run (const command::QueryTransfer &cmd)
   -> Result<Response, Exception> {
   Sol::sort = cmd.sort;
+  // the sections, their index and the queues all live in the
+  // arena, and only the answer is returned.
+  Arena::Scope arena;
   ////////////////////////////////////////////////////////////////
   // generate: Vector< Vector<Section> > Vf, Vt;
   int _no_st = 0;
-  HashMap<size_t, int > no_st;
-  Vector< Vector<Section> > Vf, Vt;
+  ArenaHashMap<size_t, int > no_st;
+  ArenaVector< ArenaVector<Section> > Vf, Vt;
   Vf.push_back({});
   Vt.push_back({});
 
   auto vTrainNum_From =
-    Train::ixStop.findMany( std::hash<std::string>()(cmd.from) );
+    Train::ixStop.findMany( std::hash<std::string_view>()(cmd.from) );
   auto vTrainNum_To =
-    Train::ixStop.findMany( std::hash<std::string>()(cmd.to) );
+    Train::ixStop.findMany( std::hash<std::string_view>()(cmd.to) );
 
   for(auto & trainPos : vTrainNum_From){
     Train train = Train::get(trainPos);
@@ -268,10 +309,7 @@ auto command::run (const command::QueryTransfer &cmd)
 
     //get st_num
 
-    long long add_price = 0;
     for(int j = it.ixKey + 1; j < train.stops.size(); ++ j){
-      add_price += train.edges[j - 1].price;
-
       int &st_num = no_st[ std::hash<std::string>()(train.stops[j])];
       if( ! st_num ) {
         st_num = ++ _no_st;
@@ -282,7 +320,7 @@ auto command::run (const command::QueryTransfer &cmd)
       it.Arrival = train.edges[j - 1].arrival
         - (train.edges[it.ixKey].departure
         - it.Departure);
-      it.totalPrice = add_price;
+      it.totalPrice = train.totalPrice(it.ixKey, j);
       Vf[st_num].push_back(it);
     }
   }
@@ -299,7 +337,6 @@ auto command::run (const command::QueryTransfer &cmd)
       + Duration( (train.begin - cmd.date) * 24 * 60) ;
     // TO BE CHECKED
 
-    long long add_price = 0;
     for(int j = it.ixKey - 1; j >= 0; --j){
       int &st_num = no_st[ std::hash<std::string>()(train.stops[j])];
       // TODO(perf): continue
@@ -313,8 +350,7 @@ auto command::run (const command::QueryTransfer &cmd)
       it.Departure = it.Arrival
         +(train.edges[j].departure
         - train.edges[ it.ixKey - 1 ].arrival);
-      add_price += train.edges[j].price;
-      it.totalPrice = add_price;
+      it.totalPrice = train.totalPrice(j, it.ixKey);
 
       //Section validity check
       for(; it.res && it.Departure.daysOverflow() < 0;){
@@ -346,14 +382,13 @@ auto command::run (const command::QueryTransfer &cmd)
     ;// std::cerr << "--- t" << std::endl;
     for (const auto &x : Vt[i]) x.output();
 
-    SectionCmp cmp {cmd.sort};
-    PriorityQueue<std::pair<Section, Section *>, SectionCmp>
+    CandidateCmp cmp {cmd.sort};
+    // pushed and popped in turns, so an array heap of small
+    // entries beats linked nodes here.
+    ArenaPriorityQueue<Candidate, CandidateCmp, panic::DaryHeap>
       queue(cmp);
-    // first: section value when add
-    // second: pointer to the real section
-    for( ; ! queue.empty(); ) queue.pop();
     for(auto &sec: Vt[i])
-      queue.push(std::make_pair( sec, &sec));
+      queue.push(sec);
 
     int mover = 0;
     Section * _mid_to = nullptr;
@@ -366,7 +401,7 @@ auto command::run (const command::QueryTransfer &cmd)
             ;// std::cerr << "moving " << Vt[i][mover].trainId << std::endl;
             Vt[i][mover].move_to_tomorrow();
             // TODO(perf)
-            queue.push({ Vt[i][mover], &Vt[i][mover] });
+            queue.push(Vt[i][mover]);
           } else {
             Vt[i][mover].deleted = true;
             break;
@@ -376,22 +411,22 @@ auto command::run (const command::QueryTransfer &cmd)
 
       Section * ans = nullptr;
       for(;! queue.empty() ;){
-        auto hd = queue.top();
-        hd.first.output();
+        const auto &hd = queue.top();
+        hd.section->output();
         // queue.pop();
 
         // cannot transfer to the same train
         bool sameTrain =
-          fromTrain.trainPos == hd.first.trainPos;
+          fromTrain.trainPos == hd.section->trainPos;
         if (sameTrain) {
           queue.pop();
           continue;
         }
-        if( hd.second->deleted || (*hd.second) != hd.first) {
+        if( hd.section->deleted || !hd.current()) {
           queue.pop();
           continue;
         }
-        ans = hd.second;
+        ans = hd.section;
         break;
       }
       if (ans == nullptr) continue;
@@ -448,22 +483,34 @@ auto rollback::run (const rollback::ReleaseTrain &log)
     // }
     ride->destroy();
   }
+  journey::invalidate();
 
   return unit;
 }
 
 void Range::output()const{
   const Train &tr = Train::get(rd.ride.train);
-  std::cout <<
+  auto &out = response::out;
+  out <<
     tr.trainId << ' ' <<
-    tr.stops[ixFrom] << ' '<<
-    formatDateTime(rd.ride.date, tr.edges[ixFrom].departure) << ' '<<
+    tr.stops[ixFrom] << ' ';
+  out.dateTime(rd.ride.date, tr.edges[ixFrom].departure) << ' '<<
     "-> " <<
-    tr.stops[ixTo] << ' ' <<
-    formatDateTime(rd.ride.date, tr.edges[ixTo - 1].arrival) << ' '<<
-    tr.totalPrice(ixFrom, ixTo) << ' ';
+    tr.stops[ixTo] << ' ';
+  out.dateTime(rd.ride.date, tr.edges[ixTo - 1].arrival) << ' '<<
+    totalPrice << ' ';
 
-  std::cout << rd.ticketsAvailable(ixFrom, ixTo) << '\n';
+  out << rd.ticketsAvailable(ixFrom, ixTo) << '\n';
+}
+void Range::encode()const{
+  const Train &tr = Train::get(rd.ride.train);
+  auto &out = response::out;
+  out.string(tr.trainId.view()).string(tr.stops[ixFrom].view());
+  out.rawDateTime(rd.ride.date, tr.edges[ixFrom].departure)
+    .string(tr.stops[ixTo].view());
+  out.rawDateTime(rd.ride.date, tr.edges[ixTo - 1].arrival)
+    .i64(totalPrice)
+    .i32(rd.ticketsAvailable(ixFrom, ixTo));
 }
 
 } // namespace ticket
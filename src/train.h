@@ -32,6 +32,16 @@ struct TrainBase {
   Id trainId;
   file::Array<Station::Id, 100> stops;
   file::Array<Edge, 99> edges;
+  /**
+   * @brief prefix sums of the edge prices, i.e. prices[i]
+   * is the price from the first stop to the i-th stop.
+   *
+   * edges[i].departure and edges[i].arrival are already
+   * cumulative from the departure of the train, so the
+   * price and the duration of any segment are both a
+   * single subtraction.
+   */
+  file::Array<int, 100> prices;
   int seats;
   Date begin, end;
   Type type;
@@ -54,10 +64,18 @@ struct Train : public file::Managed<TrainBase> {
   // released = 1
 
   /// finds the index of the station of the given name.
-  auto indexOfStop (const std::string &name) const
+  auto indexOfStop (std::string_view name) const
     -> Optional<int>;
   /// calculates the total price of a trip.
-  auto totalPrice (int ixFrom, int ixTo) const -> int;
+  auto totalPrice (int ixFrom, int ixTo) const -> int {
+    TICKET_ASSERT(ixFrom < ixTo);
+    return prices[ixTo] - prices[ixFrom];
+  }
+  /// calculates the duration of a trip.
+  auto duration (int ixFrom, int ixTo) const -> Duration {
+    TICKET_ASSERT(ixFrom < ixTo);
+    return edges[ixTo - 1].arrival - edges[ixFrom].departure;
+  }
 
   /**
    * @brief gets the remaining seats object on a given date.
@@ -126,6 +144,8 @@ struct Range{
    totalPrice(_totalPrice), time(_time), seats(_seats),trainId(_id){};
 
   void output()const;
+  /// writes the range in the binary protocol.
+  void encode()const;
 };
 
 struct Section{
@@ -166,7 +186,8 @@ struct Section{
 };
 
 struct Sol{
-  static command::SortType sort;
+  /// per thread, as the queries may run concurrently.
+  static thread_local command::SortType sort;
   Section from_mid, mid_to;
   Date date;
   Sol(const Date &dt): date(dt){};
@@ -192,7 +213,9 @@ struct Sol{
       return from_mid.trainId.str() < rhs.from_mid.trainId.str();
     return mid_to.trainId.str() < rhs.mid_to.trainId.str();
   }
-  void output()const{
+  /// gets the two rides of the transfer, unless empty().
+  Vector<Range> legs()const{
+    Vector<Range> res;
     Range tmp;
     Train train = Train::get(from_mid.trainPos);
     tmp.rd = *train.getRide(date, from_mid.ixKey);
@@ -202,7 +225,7 @@ struct Sol{
     tmp.time = from_mid.Arrival - from_mid.Departure;
     tmp.trainId = from_mid.trainId;
 
-    tmp.output();
+    res.push_back(tmp);
 
     train = Train::get(mid_to.trainPos);
     ;// std::cerr << std::string(train.begin) << std::string(train.end) << std::endl;
@@ -214,8 +237,12 @@ struct Sol{
     tmp.time = mid_to.Arrival - mid_to.Departure;
     tmp.trainId = mid_to.trainId;
 
-    tmp.output();
-
+    res.push_back(tmp);
+    return res;
+  }
+  void output()const{
+    for(auto &leg: legs())
+      leg.output();
   }
 };
 
@@ -13,19 +13,26 @@ namespace ticket {
 file::Index<User::Id, User> User::ixUsername
   {&User::username, "users.username.ix"};
 
-/// a set of users that are logged in.
-HashMap<std::string, User::Privilege> usersLoggedIn;
+/// the sessions of the users that are logged in.
+HashMap<std::string, Session, StringHash, std::equal_to<>>
+  usersLoggedIn;
+
+/// finds the session of a user, or nullptr if not logged in.
+inline auto sessionOf (std::string_view username) -> Session * {
+  auto it = usersLoggedIn.find(username);
+  if (it == usersLoggedIn.end()) return nullptr;
+  return &it->second;
+}
 
-auto UserBase::has (const char *username) -> bool {
+auto UserBase::has (std::string_view username) -> bool {
   return User::ixUsername.findOneId(username);
 }
-auto UserBase::isLoggedIn (const std::string &username)
-  -> bool {
+auto UserBase::isLoggedIn (std::string_view username) -> bool {
   return usersLoggedIn.contains(username);
 }
-auto UserBase::privilegeOf (const std::string &username)
+auto UserBase::privilegeOf (std::string_view username)
   -> User::Privilege {
-  return usersLoggedIn.at(username);
+  return sessionOf(username)->privilege;
 }
 auto UserBase::clearSessions() -> void {
   usersLoggedIn.clear();
@@ -34,14 +41,17 @@ auto UserBase::clearSessions() -> void {
 template <typename Cmd>
 inline auto checkUser (const Cmd &cmd)
   -> Result<User, Exception> {
-  if (!User::isLoggedIn(cmd.currentUser)) {
-    return Exception("not logged in");
-  }
-
-  auto target = User::ixUsername.findOne(cmd.username);
+  auto session = sessionOf(cmd.currentUser);
+  if (session == nullptr) return Exception("not logged in");
+
+  // logged in users are read from their sessions.
+  auto targetSession = sessionOf(cmd.username);
+  auto target = targetSession == nullptr
+    ? User::ixUsername.findOne(cmd.username)
+    : Optional<User>(targetSession->user);
   if (!target) return Exception("unauthorized");
 
-  auto opPrivilege = User::privilegeOf(cmd.currentUser);
+  auto opPrivilege = session->privilege;
   bool insufficientPrivileges =
     opPrivilege <= target->privilege &&
     cmd.currentUser != cmd.username;
@@ -80,7 +90,7 @@ auto command::run (const command::AddUser &cmd)
   if (privilegeCurr <= cmd.privilege) {
     return Exception("unauthorized");
   }
-  if (User::has(cmd.username.data())) {
+  if (User::has(cmd.username)) {
     return Exception("duplicate username");
   }
 
@@ -104,16 +114,18 @@ auto command::run (const command::Login &cmd)
     return Exception("already logged in");
   }
 
-  usersLoggedIn[cmd.username] = user->privilege;
+  usersLoggedIn.insert({
+    cmd.username,
+    Session { user->id(), user->privilege, *user },
+  });
   return unit;
 }
 
 auto command::run (const command::Logout &cmd)
   -> Result<Response, Exception> {
-  if (!User::isLoggedIn(cmd.username)) {
-    return Exception("not logged in");
-  }
-  usersLoggedIn.erase(usersLoggedIn.find(cmd.username));
+  auto it = usersLoggedIn.find(cmd.username);
+  if (it == usersLoggedIn.end()) return Exception("not logged in");
+  usersLoggedIn.erase(it);
   return unit;
 }
 
@@ -133,12 +145,6 @@ auto command::run (const command::ModifyProfile &cmd)
     bool authorized =
       *cmd.privilege < User::privilegeOf(cmd.currentUser);
     if (!authorized) return Exception("unauthorized");
-
-    // update privilege cache if needed
-    auto it = usersLoggedIn.find(cmd.username);
-    if (it != usersLoggedIn.end()) {
-      it->second = *cmd.privilege;
-    }
   }
 
   rollback::ModifyProfile log;
@@ -157,6 +163,12 @@ auto command::run (const command::ModifyProfile &cmd)
   // no need to update index
   rollback::log(log);
 
+  // update the session cache if needed
+  if (auto session = sessionOf(cmd.username)) {
+    session->privilege = target.privilege;
+    session->user = target;
+  }
+
   return target;
 }
 
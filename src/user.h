@@ -1,6 +1,8 @@
 #ifndef TICKET_USER_H_
 #define TICKET_USER_H_
 
+#include <string_view>
+
 #include "file/file.h"
 #include "file/index.h"
 #include "file/varchar.h"
@@ -21,14 +23,12 @@ struct UserBase {
   Privilege privilege;
 
   /// checks if there is a user with the given username.
-  static auto has (const char *username) -> bool;
+  static auto has (std::string_view username) -> bool;
   /// checks if the user is logged in.
-  static auto isLoggedIn (const std::string &username)
-    -> bool;
+  static auto isLoggedIn (std::string_view username) -> bool;
   /// returns the privilege of a user. The user has to be
   /// logged in.
-  static auto privilegeOf (const std::string &username)
-    -> int;
+  static auto privilegeOf (std::string_view username) -> int;
   /// logs out all the users.
   static auto clearSessions () -> void;
 
@@ -41,6 +41,20 @@ struct User : public file::Managed<UserBase> {
   static file::Index<User::Id, User> ixUsername;
 };
 
+/**
+ * @brief A logged in user.
+ *
+ * The session caches the user record, so that commands on
+ * logged in users need no disk access. It has to be kept in
+ * sync whenever the record changes.
+ */
+struct Session {
+  /// the numerical id of the user.
+  int id;
+  User::Privilege privilege;
+  User user;
+};
+
 } // namespace ticket
 
 #endif // TICKET_USER_H_